@@ -1,5 +1,6 @@
 #include "audioDecoding.h"
 #include <AudioToTxt.h>
+#include <MediaInput.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -17,7 +18,7 @@ extern "C"{
 bool extractAudio(const std::string mp4File, const std::string audioFile){
     //Open video file
     AVFormatContext* formatContext = nullptr;
-    if (avformat_open_input(&formatContext, mp4File.c_str(), nullptr, nullptr) != 0){
+    if (AVParser::MediaInput::open(&formatContext, mp4File) < 0){
         std::cout << "Error: Could not open input file " << mp4File << std::endl;
         return false;
     }
@@ -25,7 +26,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     //get streams
     if (avformat_find_stream_info(formatContext, nullptr) < 0){
         std::cout << "Error: Could not find stream info" << std::endl;
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -39,7 +40,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     }
     if (audioStreamIndex == -1){
         std::cout << "Error: No audio stream found" << std::endl;
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -48,7 +49,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
     if (!codec){
         std::cout << "Error: Codec not found" << std::endl;
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -57,7 +58,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     if (avcodec_parameters_to_context(codecContext, codecParams) < 0){
         std::cout << "Error: Could not initialize codec context" << std::endl;
         avcodec_free_context(&codecContext);
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -65,7 +66,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     if (avcodec_open2(codecContext, codec, nullptr) < 0){
         std::cout << "Error: Could not open codec" << std::endl;
         avcodec_free_context(&codecContext);
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -99,7 +100,7 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
         std::cout << "Error: Could not open output audio file." << std::endl;
         swr_free(&swrContext);
         avcodec_free_context(&codecContext);
-        avformat_close_input(&formatContext);
+        AVParser::MediaInput::close(&formatContext);
         return false;
     }
 
@@ -131,6 +132,6 @@ bool extractAudio(const std::string mp4File, const std::string audioFile){
     swr_free(&swrContext);
     av_frame_free(&frame);
     avcodec_free_context(&codecContext);
-    avformat_close_input(&formatContext);
+    AVParser::MediaInput::close(&formatContext);
     return true;
 }
\ No newline at end of file
@@ -52,6 +52,11 @@ namespace Audio {
     }
   }
 
+  void AudioPlayer::clear() const
+  {
+    SDL_ClearAudioStream(components.audioStream);
+  }
+
   void AudioPlayer::setVolume(const float volume) const
   {
     SDL_SetAudioStreamGain(components.audioStream, volume);
@@ -26,6 +26,9 @@ public:
 
   void queueAudio(const uint8_t* buffer, int bufferSize) const;
 
+  // Drops the queued audio that hasn't been played yet
+  void clear() const;
+
   void setVolume(float volume) const;
 
 private:
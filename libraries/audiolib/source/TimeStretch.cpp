@@ -0,0 +1,339 @@
+#include "TimeStretch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TIMESTRETCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Audio {
+  constexpr double minRate = 0.25;
+  constexpr double maxRate = 4.0;
+
+  // Segments overlap by a hop of 15 ms and may move 10 ms to line up, short enough to follow speech
+  constexpr int hopMilliseconds = 15;
+  constexpr int searchMilliseconds = 10;
+
+  constexpr float s16Scale = 32768.0f;
+
+  namespace {
+    // The kernels below run on interleaved samples, so they are the same for any channel count
+
+    float dotProduct(const float* a, const float* b, const size_t count)
+    {
+      size_t i = 0;
+      float sum = 0;
+
+#ifdef TIMESTRETCH_SSE2
+      __m128 sum0 = _mm_setzero_ps();
+      __m128 sum1 = _mm_setzero_ps();
+
+      for (; i + 8 <= count; i += 8)
+      {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+      }
+
+      float lanes[4];
+      _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+      sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+      for (; i < count; i++)
+      {
+        sum += a[i] * b[i];
+      }
+
+      return sum;
+    }
+
+    void crossFade(const float* from, const float* to, const float* fadeIn, float* out, const size_t count)
+    {
+      size_t i = 0;
+
+#ifdef TIMESTRETCH_SSE2
+      for (; i + 4 <= count; i += 4)
+      {
+        const __m128 fromSamples = _mm_loadu_ps(from + i);
+        const __m128 difference = _mm_sub_ps(_mm_loadu_ps(to + i), fromSamples);
+
+        _mm_storeu_ps(out + i, _mm_add_ps(fromSamples, _mm_mul_ps(difference, _mm_loadu_ps(fadeIn + i))));
+      }
+#endif
+
+      for (; i < count; i++)
+      {
+        out[i] = from[i] + (to[i] - from[i]) * fadeIn[i];
+      }
+    }
+
+    void s16ToFloat(const int16_t* in, float* out, const size_t count)
+    {
+      size_t i = 0;
+
+#ifdef TIMESTRETCH_SSE2
+      const __m128 scale = _mm_set1_ps(1.0f / s16Scale);
+
+      for (; i + 8 <= count; i += 8)
+      {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+
+        // Widen to 32 bits by putting each sample in the upper half and shifting it back down with its sign
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+      }
+#endif
+
+      for (; i < count; i++)
+      {
+        out[i] = static_cast<float>(in[i]) / s16Scale;
+      }
+    }
+
+    void floatToS16(const float* in, int16_t* out, const size_t count)
+    {
+      size_t i = 0;
+
+#ifdef TIMESTRETCH_SSE2
+      const __m128 scale = _mm_set1_ps(s16Scale);
+
+      for (; i + 8 <= count; i += 8)
+      {
+        // The pack saturates, so overshoot from the cross-fade clips instead of wrapping around
+        const __m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), scale));
+        const __m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+      }
+#endif
+
+      for (; i < count; i++)
+      {
+        out[i] = static_cast<int16_t>(std::clamp(std::lround(in[i] * s16Scale), -32768l, 32767l));
+      }
+    }
+  }
+
+  TimeStretch::TimeStretch(const int sampleRate, const int channels, const SampleFormat format)
+    : channels(channels), format(format),
+      hopFrames(static_cast<size_t>(sampleRate) * hopMilliseconds / 1000),
+      searchFrames(static_cast<size_t>(sampleRate) * searchMilliseconds / 1000)
+  {
+    if (sampleRate <= 0 || channels <= 0 || hopFrames == 0)
+    {
+      throw std::runtime_error("Unsupported audio format for time stretching!");
+    }
+
+    // Raised cosine, so the fade-in and the fade-out add up to one at every sample
+    fadeIn.resize(hopFrames * channels);
+    for (size_t frame = 0; frame < hopFrames; frame++)
+    {
+      const double phase = std::numbers::pi * (static_cast<double>(frame) + 0.5) / static_cast<double>(hopFrames);
+      const auto weight = static_cast<float>(0.5 - 0.5 * std::cos(phase));
+
+      std::fill_n(fadeIn.begin() + static_cast<ptrdiff_t>(frame * channels), channels, weight);
+    }
+
+    mixed.resize(hopFrames * channels);
+  }
+
+  void TimeStretch::setRate(const double rate)
+  {
+    this->rate = std::clamp(rate, minRate, maxRate);
+
+    clear();
+  }
+
+  double TimeStretch::getRate() const
+  {
+    return rate;
+  }
+
+  std::span<const uint8_t> TimeStretch::process(const std::span<const uint8_t> input)
+  {
+    if (rate == 1.0)
+    {
+      return input;
+    }
+
+    appendInput(input);
+    output.clear();
+
+    const size_t hopSamples = hopFrames * channels;
+    const double analysisHop = static_cast<double>(hopFrames) * rate;
+
+    if (!started)
+    {
+      if (getFrameCount() < hopFrames * 2)
+      {
+        return {};
+      }
+
+      // The first hop has nothing to line up with
+      appendOutput(this->input.data(), hopSamples);
+
+      previousSegment = 0;
+      analysisPosition = analysisHop;
+      started = true;
+    }
+
+    while (true)
+    {
+      const auto nominal = static_cast<size_t>(std::llround(analysisPosition));
+
+      // The rest of the previous segment and every candidate, plus one frame to slide the search window over
+      const size_t needed = std::max(previousSegment + hopFrames * 2, nominal + searchFrames + hopFrames + 1);
+      if (getFrameCount() < needed)
+      {
+        break;
+      }
+
+      const size_t segment = findBestSegment(previousSegment + hopFrames, nominal);
+
+      crossFade(&this->input[(previousSegment + hopFrames) * channels], &this->input[segment * channels],
+                fadeIn.data(), mixed.data(), hopSamples);
+      appendOutput(mixed.data(), hopSamples);
+
+      previousSegment = segment;
+      analysisPosition += analysisHop;
+    }
+
+    discardConsumedInput();
+
+    return output;
+  }
+
+  int TimeStretch::getBufferedBytes() const
+  {
+    if (rate == 1.0)
+    {
+      return 0;
+    }
+
+    const double frames = started ? static_cast<double>(getFrameCount()) - analysisPosition
+                                  : static_cast<double>(getFrameCount());
+
+    return static_cast<int>(std::max(frames, 0.0)) * channels * getBytesPerSample();
+  }
+
+  void TimeStretch::clear()
+  {
+    input.clear();
+    output.clear();
+
+    previousSegment = 0;
+    analysisPosition = 0;
+    started = false;
+  }
+
+  size_t TimeStretch::getFrameCount() const
+  {
+    return input.size() / channels;
+  }
+
+  int TimeStretch::getBytesPerSample() const
+  {
+    return format == SampleFormat::S16 ? sizeof(int16_t) : sizeof(float);
+  }
+
+  size_t TimeStretch::findBestSegment(const size_t target, const size_t nominal) const
+  {
+    const size_t first = nominal > searchFrames ? nominal - searchFrames : 0;
+    const size_t last = nominal + searchFrames;
+    const size_t hopSamples = hopFrames * channels;
+
+    const float* targetSamples = &input[target * channels];
+
+    // Energy of the candidate, slid along with it so every candidate costs one dot product
+    double energy = 0;
+    for (size_t i = 0; i < hopSamples; i++)
+    {
+      energy += static_cast<double>(input[first * channels + i]) * input[first * channels + i];
+    }
+
+    size_t bestSegment = nominal;
+    double bestScore = -std::numeric_limits<double>::infinity();
+
+    for (size_t candidate = first; candidate <= last; candidate++)
+    {
+      const float* candidateSamples = &input[candidate * channels];
+
+      // Normalised by the candidate only, the target's energy is the same for all of them
+      const double correlation = dotProduct(targetSamples, candidateSamples, hopSamples);
+      const double score = correlation / std::sqrt(std::max(energy, 1e-9));
+
+      if (score > bestScore)
+      {
+        bestScore = score;
+        bestSegment = candidate;
+      }
+
+      for (int channel = 0; channel < channels; channel++)
+      {
+        const double leaving = candidateSamples[channel];
+        const double entering = candidateSamples[hopSamples + channel];
+
+        energy += entering * entering - leaving * leaving;
+      }
+    }
+
+    return bestSegment;
+  }
+
+  void TimeStretch::appendInput(const std::span<const uint8_t> data)
+  {
+    const size_t sampleCount = data.size() / getBytesPerSample() / channels * channels;
+    const size_t offset = input.size();
+
+    input.resize(offset + sampleCount);
+
+    if (format == SampleFormat::S16)
+    {
+      s16ToFloat(reinterpret_cast<const int16_t*>(data.data()), input.data() + offset, sampleCount);
+    }
+    else
+    {
+      std::memcpy(input.data() + offset, data.data(), sampleCount * sizeof(float));
+    }
+  }
+
+  void TimeStretch::appendOutput(const float* samples, const size_t count)
+  {
+    const size_t offset = output.size();
+    output.resize(offset + count * getBytesPerSample());
+
+    if (format == SampleFormat::S16)
+    {
+      floatToS16(samples, reinterpret_cast<int16_t*>(output.data() + offset), count);
+    }
+    else
+    {
+      std::memcpy(output.data() + offset, samples, count * sizeof(float));
+    }
+  }
+
+  void TimeStretch::discardConsumedInput()
+  {
+    const auto nominal = static_cast<size_t>(analysisPosition);
+    const size_t oldestNeeded = std::min(previousSegment + hopFrames, nominal > searchFrames ? nominal - searchFrames : 0);
+
+    // Shifting is cheap next to the search, but not worth doing for a few frames
+    if (oldestNeeded < hopFrames)
+    {
+      return;
+    }
+
+    input.erase(input.begin(), input.begin() + static_cast<ptrdiff_t>(oldestNeeded * channels));
+
+    previousSegment -= oldestNeeded;
+    analysisPosition -= static_cast<double>(oldestNeeded);
+  }
+} // Audio
@@ -0,0 +1,76 @@
+#ifndef TIMESTRETCH_H
+#define TIMESTRETCH_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Audio {
+
+enum class SampleFormat {
+  S16,
+  F32
+};
+
+// Changes the speed of a stream of interleaved PCM without changing its pitch (WSOLA). Every output block cross-fades
+// the end of the previous input segment into the segment near the next analysis position that lines up best with it
+class TimeStretch {
+public:
+  TimeStretch(int sampleRate, int channels, SampleFormat format);
+
+  // Speed of the output relative to the input, clamped to 0.25x - 4x. Drops the buffered input
+  void setRate(double rate);
+
+  [[nodiscard]] double getRate() const;
+
+  // Stretches the next whole frames of the stream. The output is valid until the next call, at 1x it is the input
+  [[nodiscard]] std::span<const uint8_t> process(std::span<const uint8_t> input);
+
+  // Bytes of input that were passed in but aren't in the output yet
+  [[nodiscard]] int getBufferedBytes() const;
+
+  // Drops the buffered input, e.g. after a seek
+  void clear();
+
+private:
+  int channels;
+  SampleFormat format;
+  double rate = 1.0;
+
+  // Frames output per step, which is also the length of the cross-fade
+  size_t hopFrames;
+
+  // How far from the analysis position a segment may start to line up with the previous one
+  size_t searchFrames;
+
+  // Interleaved input from the oldest frame still needed
+  std::vector<float> input;
+
+  // Fade-in weight of every interleaved sample of a hop, the previous segment fades out by the rest
+  std::vector<float> fadeIn;
+
+  std::vector<float> mixed;
+  std::vector<uint8_t> output;
+
+  // Start of the last segment and the position the next one should start near, in frames into input
+  size_t previousSegment = 0;
+  double analysisPosition = 0;
+  bool started = false;
+
+  [[nodiscard]] size_t getFrameCount() const;
+
+  [[nodiscard]] int getBytesPerSample() const;
+
+  // Segment start within searchFrames of nominal whose first hop is most similar to the hop at target
+  [[nodiscard]] size_t findBestSegment(size_t target, size_t nominal) const;
+
+  void appendInput(std::span<const uint8_t> data);
+
+  void appendOutput(const float* samples, size_t count);
+
+  void discardConsumedInput();
+};
+
+} // Audio
+
+#endif //TIMESTRETCH_H
@@ -0,0 +1,115 @@
+#include <TimeStretch.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+
+constexpr int sampleRate = 44100;
+constexpr int channels = 2;
+constexpr int seconds = 60;
+
+// Frames handed to the stretcher at a time, like the chunks the media parser decodes
+constexpr size_t chunkFrames = 4096;
+
+// A voice-like signal: a harmonic tone with vibrato and a little noise, slightly different on both channels
+std::vector<float> generateSignal()
+{
+  std::vector<float> samples(static_cast<size_t>(sampleRate) * seconds * channels);
+
+  std::mt19937 random(362);
+  std::uniform_real_distribution noise(-0.02f, 0.02f);
+
+  double phase = 0;
+  for (size_t frame = 0; frame < samples.size() / channels; frame++)
+  {
+    const double time = static_cast<double>(frame) / sampleRate;
+    const double frequency = 180.0 + 20.0 * std::sin(2 * std::numbers::pi * 5 * time);
+    phase += 2 * std::numbers::pi * frequency / sampleRate;
+
+    double value = 0;
+    for (int harmonic = 1; harmonic <= 6; harmonic++)
+    {
+      value += std::sin(phase * harmonic) / (harmonic * 3.0);
+    }
+
+    for (int channel = 0; channel < channels; channel++)
+    {
+      samples[frame * channels + channel] = static_cast<float>(value * (channel == 0 ? 1.0 : 0.8)) + noise(random);
+    }
+  }
+
+  return samples;
+}
+
+std::vector<uint8_t> toBytes(const std::vector<float>& samples, const Audio::SampleFormat format)
+{
+  if (format == Audio::SampleFormat::F32)
+  {
+    std::vector<uint8_t> bytes(samples.size() * sizeof(float));
+    std::memcpy(bytes.data(), samples.data(), bytes.size());
+    return bytes;
+  }
+
+  std::vector<uint8_t> bytes(samples.size() * sizeof(int16_t));
+  for (size_t i = 0; i < samples.size(); i++)
+  {
+    const auto sample = static_cast<int16_t>(std::lround(samples[i] * 32767.0f));
+    std::memcpy(bytes.data() + i * sizeof(int16_t), &sample, sizeof(sample));
+  }
+
+  return bytes;
+}
+
+// Stretches the whole signal in chunks, returns how many times faster than real time it ran and the output length
+std::pair<double, double> benchmark(const std::vector<uint8_t>& input, const Audio::SampleFormat format,
+                                    const double rate)
+{
+  Audio::TimeStretch timeStretch(sampleRate, channels, format);
+  timeStretch.setRate(rate);
+
+  const size_t bytesPerFrame = channels * (format == Audio::SampleFormat::S16 ? sizeof(int16_t) : sizeof(float));
+  const size_t chunkBytes = chunkFrames * bytesPerFrame;
+  size_t outputBytes = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t offset = 0; offset < input.size(); offset += chunkBytes)
+  {
+    const size_t size = std::min(chunkBytes, input.size() - offset);
+    outputBytes += timeStretch.process({ input.data() + offset, size }).size();
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  const double outputSeconds = static_cast<double>(outputBytes / bytesPerFrame) / sampleRate;
+
+  return { seconds / elapsed.count(), outputSeconds };
+}
+
+int main()
+{
+  const auto signal = generateSignal();
+
+  constexpr double rates[] = { 0.5, 0.75, 1.25, 1.5, 2.0, 3.0 };
+
+  for (const auto format : { Audio::SampleFormat::S16, Audio::SampleFormat::F32 })
+  {
+    const auto input = toBytes(signal, format);
+
+    std::cout << (format == Audio::SampleFormat::S16 ? "S16" : "F32") << " stereo, " << seconds << " s at "
+              << sampleRate << " Hz" << std::endl;
+
+    for (const double rate : rates)
+    {
+      const auto [realTimeFactor, outputSeconds] = benchmark(input, format, rate);
+
+      std::cout << "  " << rate << "x: " << realTimeFactor << "x real time, " << outputSeconds << " s out (expected "
+                << seconds / rate << " s)" << std::endl;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -2,60 +2,78 @@
 extern "C" {
 #include <libavutil/opt.h>
 }
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <ranges>
 #include <thread>
+#include <limits>
+#include <optional>
+#include <unordered_map>
 
 namespace AVParser {
-  MediaParser::MediaParser(const std::string& mediaFile, const AudioParams& params)
-    : currentFrame(0), currentVideoData(std::make_shared<std::vector<uint8_t>>()),
-      backgroundVideoData(std::make_shared<std::vector<uint8_t>>()),
-      currentAudioData(std::make_shared<std::vector<uint8_t>>()), previousTime(std::chrono::steady_clock::now()),
-      params(params)
-  {
-    if (avformat_open_input(&formatContext, mediaFile.c_str(), nullptr, nullptr) < 0)
-    {
-      throw std::runtime_error("Failed to open video file!");
-    }
+  // Decoded audio kept in the ring, enough for the GOPs around the playhead
+  constexpr size_t audioRingSeconds = 60;
 
-    if (avformat_find_stream_info(formatContext, nullptr) < 0)
-    {
-      throw std::runtime_error("Failed to retrieve stream info!");
-    }
+  // Audio handed out per getNextAudioChunk call at most
+  constexpr size_t audioChunkFrames = 4096;
 
-    findStreamIndices();
+  // Frames the loader prepares ahead of the playhead
+  constexpr size_t readyFrameCapacity = 16;
 
-    setupVideo();
+  // Range of the playback rate, and the rate from which only keyframes are decoded instead of every frame
+  constexpr double minPlaybackRate = 0.25;
+  constexpr double maxPlaybackRate = 64.0;
+  constexpr double keyFrameOnlyRate = 8.0;
 
-    setupAudio();
+  // Keyframe only playback decodes the keyframes the clock reaches within this many seconds ahead of time, spread over
+  // this many keyframes, and keeps a few more for the ones on screen
+  constexpr double keyFrameLookAheadSeconds = 0.5;
+  constexpr uint32_t keyFrameLookAhead = 4;
+  constexpr size_t fastPlaybackCacheSize = keyFrameLookAhead * 2;
 
-    loadKeyframes();
+  // Scrub previews are scaled down to fit this size, keeping the aspect ratio. Enough of them are kept for dragging
+  // back and forth over the same keyframes
+  constexpr int scrubPreviewWidth = 640;
+  constexpr int scrubPreviewHeight = 640;
+  constexpr size_t scrubCacheSize = 32;
 
-    calculateTotalFrames();
+  // Rates the audio is played at, outside of them it wouldn't be intelligible anyway
+  constexpr double minAudibleRate = 0.5;
+  constexpr double maxAudibleRate = 3.0;
+
+  // Opening waits for the GOP of its first frame this long at a time, submitting it again in case it was cancelled,
+  // and gives up after this many timeouts
+  constexpr auto gopWaitTimeout = std::chrono::milliseconds(100);
+  constexpr uint32_t maxGopWaits = 20;
 
-    frame = av_frame_alloc();
-    packet = av_packet_alloc();
+  // A cache miss on the player thread waits at most this long, a GOP that takes longer is shown by update once it lands
+  constexpr auto maxFrameWait = std::chrono::milliseconds(40);
+
+  // Relative change of the output size that makes it worth decoding the cached GOPs again, e.g. while resizing
+  constexpr double outputResizeThreshold = 0.15;
+
+  MediaParser::MediaParser(const std::string& mediaFile, const AudioParams& params, const DecoderParams& decoderParams,
+                           const OpenMode openMode)
+    : currentFrame(0), currentVideoData(std::make_shared<std::vector<uint8_t>>()),
+      currentAudioData(std::make_shared<std::vector<uint8_t>>()), previousTime(std::chrono::steady_clock::now()),
+      openMode(openMode), readyFrames(readyFrameCapacity), params(params), decoderParams(decoderParams),
+      audioRing(static_cast<size_t>(params.sampleRate) * audioRingSeconds,
+                params.channels * (params.bitsPerSample / 8))
+  {
+    openMedia(mediaFile);
 
     backgroundThread = std::thread(&MediaParser::backgroundFrameLoader, this);
 
     loadNextFrame();
+    waitForMissedFrame();
   }
 
   MediaParser::~MediaParser()
   {
-    keepLoadingInBackground = false;
-    backgroundThread.join();
-
-    av_packet_free(&packet);
-    av_frame_free(&frame);
-
-    swr_free(&swrContext);
-    avcodec_free_context(&audioCodecContext);
-
-    sws_freeContext(swsContext);
-    avcodec_free_context(&videoCodecContext);
+    stopBackgroundLoader();
 
-    avformat_close_input(&formatContext);
+    closeMedia();
   }
 
   AVFrameData MediaParser::getCurrentFrame() const
@@ -63,8 +81,11 @@ namespace AVParser {
     return {
       .videoData = currentVideoData,
       .audioData = currentAudioData,
-      .frameWidth = getFrameWidth(),
-      .frameHeight = getFrameHeight()
+      .frameWidth = currentVideoWidth,
+      .frameHeight = currentVideoHeight,
+      .frameFormat = decoderParams.frameFormat,
+      .colorMatrix = colorMatrix,
+      .fullRange = fullRange
     };
   }
 
@@ -82,7 +103,25 @@ namespace AVParser {
 
   uint32_t MediaParser::getTotalFrames() const
   {
-    return totalFrames;
+    const auto index = getIndex();
+
+    if (index->complete && !index->packets.empty())
+    {
+      return index->lastFrame;
+    }
+
+    // The container's count is only an estimate, but the timeline needs a length before the whole file is read
+    return std::max(index->lastFrame, estimatedTotalFrames);
+  }
+
+  bool MediaParser::isIndexComplete() const
+  {
+    return getIndex()->complete;
+  }
+
+  uint32_t MediaParser::getIndexedFrames() const
+  {
+    return getIndex()->lastFrame;
   }
 
   uint32_t MediaParser::getCurrentFrameIndex() const
@@ -90,17 +129,32 @@ namespace AVParser {
     return currentFrame;
   }
 
+  bool MediaParser::isAtEnd() const
+  {
+    const auto index = getIndex();
+
+    return index->complete && currentFrame >= index->lastFrame;
+  }
+
   void MediaParser::loadNextFrame()
   {
-    if (currentFrame + 1 > getTotalFrames())
+    const auto index = getIndex();
+
+    if (currentFrame + 1 > index->lastFrame)
     {
-      state = MediaState::PAUSED;
+      // Before the end of a partial index the next frame just isn't indexed yet
+      if (index->complete)
+      {
+        state = MediaState::PAUSED;
+      }
       return;
     }
 
     loadFrameFromCache(currentFrame + 1);
 
     currentFrame++;
+
+    wakeLoader();
   }
 
   void MediaParser::loadPreviousFrame()
@@ -113,6 +167,8 @@ namespace AVParser {
     loadFrameFromCache(currentFrame - 1);
 
     currentFrame--;
+
+    wakeLoader();
   }
 
   void MediaParser::loadFrameAt(const uint32_t targetFrame)
@@ -122,80 +178,227 @@ namespace AVParser {
       throw std::out_of_range("Target frame is out of range!");
     }
 
+    // Frames past a partial index can't be found yet, the playhead stops at the last indexed one
+    const auto index = getIndex();
+    const uint32_t frame = std::min(targetFrame, index->lastFrame);
+
     state = MediaState::PAUSED;
 
-    currentFrame = targetFrame;
+    currentFrame = frame;
 
-    loadFrameFromCache(targetFrame);
+    // Whatever was queued for the old position is no longer needed. The epoch is bumped after the playhead moved, so
+    // a loader that sees the new epoch also sees the new playhead
+    decodePool->cancelPending();
+    readPrefetcher->cancel();
+    ++seekEpoch;
 
-    // Calculate the correct audio chunk based on frame rate and target frame
-    const double frameRate = getFrameRate();
-    const AVStream* audioStream = formatContext->streams[audioStreamIndex];
-    const double audioPtsPerSecond = 1.0 / av_q2d(audioStream->time_base);
+    loadFrameFromCache(frame);
 
-    // Calculate the timestamp in seconds for the target frame
-    const double targetTimeInSeconds = static_cast<double>(targetFrame) / frameRate;
+    // Continue the audio alongside the target frame, the buffered audio is kept if the target is inside it
+    audioRing.seek(getAudioSample(index->packets.getFrameTime(frame)));
+    audioNeedsSeek = false;
 
-    // Convert time to audio PTS
-    const auto targetAudioPts = static_cast<int64_t>(targetTimeInSeconds * audioPtsPerSecond);
+    wakeLoader();
+  }
 
-    // Find the closest audio chunk to this PTS
-    auto it = audioCache.lower_bound(targetAudioPts);
+  void MediaParser::update()
+  {
+    const auto dt = advanceTime();
+    if (!dt)
+    {
+      return;
+    }
 
-    // If we found an exact match or a later chunk
-    if (it != audioCache.end())
+    playbackClock += *dt;
+
+    presentDueFrame();
+  }
+
+  void MediaParser::update(const int queuedAudioBytes)
+  {
+    const auto dt = advanceTime();
+    if (!dt)
     {
-      // Calculate the index (distance from beginning)
-      currentAudioChunk = std::distance(audioCache.begin(), it);
+      return;
     }
-    else if (!audioCache.empty())
+
+    if (isAudible() && queuedAudioBytes > 0 && audioStreamIndex != -1)
     {
-      // If no exact match found, use the last available chunk
-      currentAudioChunk = audioCache.size() - 1;
+      // The ring's read position is what was handed to the device, the queued part of it hasn't been heard yet
+      const int bytesPerFrame = params.channels * (params.bitsPerSample / 8);
+      const int64_t playedSample = audioRing.getReadSample() - queuedAudioBytes / bytesPerFrame;
+
+      playbackClock = static_cast<double>(playedSample) / params.sampleRate;
     }
     else
     {
-      // No audio chunks available
-      currentAudioChunk = 0;
+      // No audio is playing (none in the file, past its end, in reverse or too fast), keep going on the system clock
+      playbackClock += *dt;
     }
+
+    presentDueFrame();
   }
 
-  void MediaParser::update()
+  std::optional<double> MediaParser::advanceTime()
   {
-    const float fixedUpdateDt = 1.0f / static_cast<float>(getFrameRate());
     const auto currentTime = std::chrono::steady_clock::now();
-    const float dt = std::chrono::duration<float>(currentTime - previousTime).count();
+    const double dt = std::chrono::duration<double>(currentTime - previousTime).count();
     previousTime = currentTime;
-    timeAccumulator += dt;
 
-    if (state == MediaState::AUTO_PLAYING)
+    if (scrubbing)
     {
-      while (timeAccumulator >= fixedUpdateDt)
-      {
-        loadNextFrame();
+      // Show previews that finished decoding since the last scrubTo
+      presentScrubFrame();
+    }
+    else if (missedFrame)
+    {
+      presentMissedFrame();
+    }
+
+    if (thumbnailsPending && isIndexComplete())
+    {
+      startThumbnails();
+    }
+
+    if (state != MediaState::AUTO_PLAYING && state != MediaState::REVERSE_PLAYING)
+    {
+      playbackClock = getIndex()->packets.getFrameTime(currentFrame);
+      return std::nullopt;
+    }
+
+    return (state == MediaState::REVERSE_PLAYING ? -dt : dt) * playbackRate;
+  }
+
+  void MediaParser::presentDueFrame()
+  {
+    const auto index = getIndex();
+    const bool reverse = state == MediaState::REVERSE_PLAYING;
+    const bool keyFrameOnly = isKeyFrameOnly();
+    const double frameDuration = 1.0 / getFrameRate();
+
+    // The clock waits at the end of a partial index until the indexer gets further
+    if (!index->complete)
+    {
+      playbackClock = std::min(playbackClock, index->packets.getFrameTime(index->lastFrame));
+    }
+
+    const uint32_t dueFrame = std::min(index->packets.findFrame(playbackClock), index->lastFrame);
+
+    // Backwards the clock enters a frame at its end, so that is what lateness and drift are measured from
+    const auto getTrail = [&](const uint32_t frame) {
+      const double frameTime = index->packets.getFrameTime(frame);
+
+      return reverse ? frameTime + frameDuration - playbackClock : playbackClock - frameTime;
+    };
+
+    if (keyFrameOnly && dueFrame != currentFrame)
+    {
+      // Frames in between are skipped on purpose, so they don't count as dropped
+      currentFrame = dueFrame;
+      audioNeedsSeek = true;
+
+      requestKeyFrames(*index, dueFrame, reverse);
+    }
+    else if (reverse ? dueFrame < currentFrame : dueFrame > currentFrame)
+    {
+      playbackStats.droppedFrames += (reverse ? currentFrame - dueFrame : dueFrame - currentFrame) - 1;
 
-        timeAccumulator -= fixedUpdateDt;
+      loadFrameFromCache(dueFrame);
+
+      currentFrame = dueFrame;
+      audioNeedsSeek |= !isAudible();
+
+      wakeLoader();
+
+      if (getTrail(dueFrame) > 0.5 * frameDuration)
+      {
+        playbackStats.lateFrames++;
       }
     }
-    else if (state == MediaState::PAUSED || state == MediaState::MANUAL)
+
+    if (keyFrameOnly)
+    {
+      presentKeyFrame();
+    }
+
+    playbackStats.drift = getTrail(currentFrame);
+
+    // Hold the last frame for its duration before stopping, backwards the first one is held until the clock reaches it
+    const bool finished = reverse ? currentFrame == 0 && playbackClock <= index->packets.getFrameTime(0)
+                                  : index->complete && currentFrame >= index->lastFrame &&
+                                    playbackClock >= index->packets.getFrameTime(currentFrame) + frameDuration;
+    if (finished)
     {
-      timeAccumulator = std::fmod(timeAccumulator, fixedUpdateDt);
+      pause();
     }
   }
 
   void MediaParser::play()
   {
+    if (state == MediaState::REVERSE_PLAYING)
+    {
+      // Frames queued backwards are behind the playhead now
+      ++seekEpoch;
+    }
+
     state = MediaState::AUTO_PLAYING;
+
+    syncAudio();
+
+    wakeLoader();
+  }
+
+  void MediaParser::playReverse()
+  {
+    if (state == MediaState::REVERSE_PLAYING)
+    {
+      return;
+    }
+
+    state = MediaState::REVERSE_PLAYING;
+    audioNeedsSeek = true;
+
+    // Frames queued for forward playback are behind the playhead now. Bumped after the state changed, so a loader
+    // that sees the new epoch also queues backwards
+    ++seekEpoch;
+
+    wakeLoader();
   }
 
   void MediaParser::pause()
   {
+    const bool keyFrameOnly = isKeyFrameOnly();
+
     state = MediaState::PAUSED;
+
+    if (keyFrameOnly)
+    {
+      // Only the keyframe before the playhead is on screen
+      loadFrameFromCache(currentFrame);
+    }
+
+    wakeLoader();
   }
 
   void MediaParser::setManual(const bool manual)
   {
+    const bool keyFrameOnly = isKeyFrameOnly();
+
+    if (state == MediaState::REVERSE_PLAYING)
+    {
+      ++seekEpoch;
+    }
+
     state = manual ? MediaState::MANUAL : MediaState::AUTO_PLAYING;
+
+    if (keyFrameOnly && !isKeyFrameOnly())
+    {
+      loadFrameFromCache(currentFrame);
+    }
+
+    syncAudio();
+
+    wakeLoader();
   }
 
   MediaState MediaParser::getState() const
@@ -203,28 +406,291 @@ namespace AVParser {
     return state;
   }
 
-  bool MediaParser::getNextAudioChunk(uint8_t*& outBuffer, int& outBufferSize)
+  void MediaParser::setPlaybackRate(const double rate)
   {
-    if (currentAudioChunk >= audioCache.size())
+    const bool keyFrameOnly = isKeyFrameOnly();
+
+    playbackRate = std::clamp(rate, minPlaybackRate, maxPlaybackRate);
+
+    if (!keyFrameOnly && isKeyFrameOnly())
     {
-      return false;
+      // The GOPs around the playhead won't be shown, leave the workers free for the frame playback slows down on
+      decodePool->cancelPending();
+      readPrefetcher->cancel();
+    }
+    else if (keyFrameOnly && !isKeyFrameOnly())
+    {
+      loadFrameFromCache(currentFrame);
+    }
+
+    if (state == MediaState::AUTO_PLAYING)
+    {
+      syncAudio();
     }
 
-    const auto it = std::next(audioCache.begin(), currentAudioChunk); // Efficient lookup
+    wakeLoader();
+  }
 
-    if (it == audioCache.end())
+  double MediaParser::getPlaybackRate() const
+  {
+    return playbackRate;
+  }
+
+  bool MediaParser::isAudible() const
+  {
+    return state != MediaState::REVERSE_PLAYING && playbackRate >= minAudibleRate && playbackRate <= maxAudibleRate;
+  }
+
+  void MediaParser::beginScrub()
+  {
+    if (scrubbing)
     {
-      return false;
+      return;
+    }
+
+    stateBeforeScrub = state;
+    state = MediaState::PAUSED;
+    scrubbing = true;
+
+    // The GOPs around the old position won't be shown, leave the workers free for the exact frame at the end
+    decodePool->cancelPending();
+    readPrefetcher->cancel();
+
+    wakeLoader();
+  }
+
+  void MediaParser::scrubTo(const uint32_t targetFrame)
+  {
+    if (targetFrame > getTotalFrames())
+    {
+      throw std::out_of_range("Target frame is out of range!");
+    }
+
+    beginScrub();
+
+    // Like loadFrameAt, the preview stops at the end of a partial index
+    const auto index = getIndex();
+    currentFrame = std::min(targetFrame, index->lastFrame);
+
+    const uint32_t keyFrame = getKeyFrame(*index, currentFrame);
+    scrubDecoder->request(keyFrame, index->keyFrameMap.at(static_cast<int>(keyFrame)));
+
+    presentScrubFrame();
+  }
+
+  void MediaParser::endScrub()
+  {
+    if (!scrubbing)
+    {
+      return;
+    }
+
+    scrubbing = false;
+
+    loadFrameAt(currentFrame);
+
+    state = stateBeforeScrub;
+
+    wakeLoader();
+  }
+
+  bool MediaParser::isScrubbing() const
+  {
+    return scrubbing;
+  }
+
+  void MediaParser::setOutputSize(const int width, const int height)
+  {
+    requestedOutputWidth = std::max(width, 0);
+    requestedOutputHeight = std::max(height, 0);
+
+    const auto [newWidth, newHeight] = getFittedOutputSize();
+
+    const auto changedBy = [](const int from, const int to) {
+      return std::abs(to - from) / static_cast<double>(std::max(from, 1));
+    };
+
+    // Going back to the video's own size is always applied, the frames are then exact
+    const bool native = newWidth == getFrameWidth() && newHeight == getFrameHeight();
+
+    if ((newWidth == outputWidth && newHeight == outputHeight) ||
+        (!native && changedBy(outputWidth, newWidth) <= outputResizeThreshold &&
+         changedBy(outputHeight, newHeight) <= outputResizeThreshold))
+    {
+      return;
+    }
+
+    applyOutputSize(newWidth, newHeight);
+  }
+
+  std::pair<int, int> MediaParser::getFittedOutputSize() const
+  {
+    const int width = getFrameWidth();
+    const int height = getFrameHeight();
+
+    if (requestedOutputWidth <= 0 || requestedOutputHeight <= 0)
+    {
+      return { width, height };
+    }
+
+    const auto [fittedWidth, fittedHeight] = fitFrameSize(width, height, requestedOutputWidth, requestedOutputHeight);
+    if (fittedWidth == width && fittedHeight == height)
+    {
+      return { width, height };
+    }
+
+    // NV12 subsamples the chroma by two in both directions
+    return { std::max(fittedWidth & ~1, 2), std::max(fittedHeight & ~1, 2) };
+  }
+
+  void MediaParser::applyOutputSize(const int width, const int height)
+  {
+    // Workers drop GOPs still being decoded at the old size, so none of them reach the cache after it is cleared
+    decodePool->setOutputSize(width, height);
+    outputWidth = width;
+    outputHeight = height;
+
+    videoCache.clear();
+    framePool.trim();
+
+    // Frames the loader queued at the old size are discarded like after a seek
+    ++seekEpoch;
+
+    // Keyframes are decoded again at the new size
+    fastPlaybackDecoder.reset();
+
+    // A preview stays on screen until the scrub ends, everything else is shown again at the new size
+    if (isKeyFrameOnly())
+    {
+      requestKeyFrames(*getIndex(), currentFrame, state == MediaState::REVERSE_PLAYING);
+    }
+    else if (!scrubbing)
+    {
+      loadFrameFromCache(currentFrame);
     }
 
-    outBuffer = it->second.data();
-    outBufferSize = static_cast<int>(it->second.size());
+    wakeLoader();
+  }
 
-    currentAudioChunk++;
+  void MediaParser::setCurrentVideoData(FrameBuffer buffer, const int width, const int height)
+  {
+    currentVideoData = std::move(buffer);
+    currentVideoWidth = width;
+    currentVideoHeight = height;
+  }
+
+  bool MediaParser::getNextAudioChunk(const uint8_t*& outBuffer, int& outBufferSize)
+  {
+    const auto chunk = audioRing.read(audioChunkFrames);
+
+    if (chunk.empty())
+    {
+      return false;
+    }
+
+    outBuffer = chunk.data();
+    outBufferSize = static_cast<int>(chunk.size());
 
     return true;
   }
 
+  bool MediaParser::isAudioFinished() const
+  {
+    // A seek out of the buffered audio discards the end along with the rest
+    return audioEndResets == audioRing.getResetCount() && audioRing.getReadSample() >= audioRing.getEndSample();
+  }
+
+  void MediaParser::openMedia(const std::string& mediaFile)
+  {
+    if (MediaInput::open(&formatContext, mediaFile) < 0)
+    {
+      throw std::runtime_error("Failed to open video file!");
+    }
+
+    if (avformat_find_stream_info(formatContext, nullptr) < 0)
+    {
+      throw std::runtime_error("Failed to retrieve stream info!");
+    }
+
+    findStreamIndices();
+
+    setupVideo();
+
+    setupAudio();
+
+    // A progressive open indexes the file in the background while the decoders are set up
+    loadKeyframes();
+
+    calculateTotalFrames();
+
+    videoCache.setByteBudget(decoderParams.videoCacheBytes);
+    decodePool = std::make_unique<DecodePool>(mediaFile, videoStreamIndex, videoCache, framePool, decoderParams);
+    readPrefetcher = std::make_unique<ReadPrefetcher>(mediaFile, decoderParams.readBackend,
+                                                      decoderParams.readQueueDepth);
+
+    const auto [width, height] = getFittedOutputSize();
+    outputWidth = width;
+    outputHeight = height;
+    decodePool->setOutputSize(width, height);
+    scrubDecoder = std::make_unique<ScrubDecoder>(mediaFile, videoStreamIndex, decoderParams.frameFormat,
+                                                  scrubPreviewWidth, scrubPreviewHeight, scrubCacheSize);
+
+    // Only the first GOP has to be indexed to show the first frame, however long the file is
+    waitForIndex();
+
+    startThumbnails();
+  }
+
+  void MediaParser::closeMedia()
+  {
+    // Stop the workers before the cache they publish into is cleared
+    indexBuilder.reset();
+    decodePool.reset();
+    readPrefetcher.reset();
+    scrubDecoder.reset();
+    fastPlaybackDecoder.reset();
+    thumbnails.reset();
+    thumbnailsPending = false;
+    scrubbing = false;
+
+    {
+      std::lock_guard lock(indexMutex);
+      indexSnapshot.reset();
+    }
+
+    readyFrames.clear();
+    nextQueuedFrame = 0;
+    accessPattern = AccessPattern::NORMAL;
+
+    videoCache.clear();
+    framePool.trim();
+    audioRing.clear();
+    audioGops.clear();
+    audioEndResets = noAudioEnd;
+
+    swr_free(&swrContext);
+    avcodec_free_context(&audioCodecContext);
+
+    avcodec_free_context(&videoCodecContext);
+
+    MediaInput::close(&formatContext);
+  }
+
+  CacheStats MediaParser::getCacheStats() const
+  {
+    return videoCache.getStats();
+  }
+
+  PlaybackStats MediaParser::getPlaybackStats() const
+  {
+    return playbackStats;
+  }
+
+  const ThumbnailGenerator& MediaParser::getThumbnails() const
+  {
+    return *thumbnails;
+  }
+
   int MediaParser::getFrameWidth() const
   {
     validateVideoContext();
@@ -279,200 +745,160 @@ namespace AVParser {
       throw std::runtime_error("Failed to open video codec!");
     }
 
-    swsContext = sws_getContext(videoCodecContext->width, videoCodecContext->height,
-                                videoCodecContext->pix_fmt, videoCodecContext->width,
-                                videoCodecContext->height, AV_PIX_FMT_RGBA, SWS_BILINEAR,
-                                nullptr, nullptr, nullptr);
+    // Matrix used to convert NV12 frames back to RGB, untagged streams are assumed to follow their resolution
+    switch (videoCodecContext->colorspace)
+    {
+      case AVCOL_SPC_RGB: // Converted to YUV by swscale with its BT.601 default
+      case AVCOL_SPC_BT470BG:
+      case AVCOL_SPC_SMPTE170M:
+        colorMatrix = ColorMatrix::BT601;
+        break;
+      case AVCOL_SPC_BT709:
+        colorMatrix = ColorMatrix::BT709;
+        break;
+      case AVCOL_SPC_BT2020_NCL:
+      case AVCOL_SPC_BT2020_CL:
+        colorMatrix = ColorMatrix::BT2020;
+        break;
+      default:
+        colorMatrix = videoCodecContext->height >= 720 ? ColorMatrix::BT709 : ColorMatrix::BT601;
+        break;
+    }
+
+    // swscale already scales the deprecated full range "J" formats down to limited range NV12
+    fullRange = videoCodecContext->color_range == AVCOL_RANGE_JPEG && videoCodecContext->pix_fmt != AV_PIX_FMT_YUVJ420P;
   }
 
   void MediaParser::loadKeyframes()
   {
-    const AVStream* videoStream = formatContext->streams[videoStreamIndex];
-
-    av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
-
-    // Read packets and store keyframe positions
-    AVPacket packet;
-    bool firstKeyframeFound = false;
-    int64_t firstKeyframePts = 0;
-
-    // First pass: find the first keyframe's PTS
-    while (!firstKeyframeFound && av_read_frame(formatContext, &packet) >= 0)
+    // Reuse the index from a previous open of the same file when possible, it is only a cache so any failure
+    // just falls back to scanning the file
+    fileKey.reset();
+    try
     {
-      if (packet.stream_index == videoStreamIndex && packet.flags & AV_PKT_FLAG_KEY)
-      {
-        firstKeyframePts = packet.pts;
-        firstKeyframeFound = true;
-      }
-      av_packet_unref(&packet);
+      fileKey = IndexCache::getMediaFileKey(formatContext->url);
     }
+    catch (const std::exception&) {}
 
-    /* Find Video Keyframes */
-    // Reset to beginning
-    av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
+    PacketIndex packets;
 
-    while (av_read_frame(formatContext, &packet) >= 0)
+    if (fileKey && packets.load(IndexCache::getCachePath(*fileKey, ".idx"), *fileKey,
+                                videoStreamIndex, audioStreamIndex))
     {
-      if (packet.stream_index == videoStreamIndex && packet.flags & AV_PKT_FLAG_KEY)
-      {
-        // Calculate frame number relative to the first keyframe
-        const int64_t pts = packet.pts;
-        const int64_t ptsDiff = pts - firstKeyframePts;
+      publishIndex(std::move(packets), true);
+      return;
+    }
 
-        const double frameDuration = av_q2d(AVRational{
-          videoStream->avg_frame_rate.den,
-          videoStream->avg_frame_rate.num
-        });
+    if (openMode == OpenMode::PROGRESSIVE)
+    {
+      auto publish = [this](PacketIndex index, const bool complete) {
+        // Only the complete index is cached, a partial one would be taken for the whole file on the next open
+        if (complete && fileKey)
+        {
+          index.save(IndexCache::getCachePath(*fileKey, ".idx"), *fileKey);
+        }
 
-        int frameNumber = static_cast<int>(static_cast<double>(ptsDiff) * av_q2d(videoStream->time_base) / frameDuration);
+        publishIndex(std::move(index), complete);
+      };
 
-        // The first keyframe becomes frame 0
-        keyFrameMap[frameNumber] = true;
-      }
-      av_packet_unref(&packet);
+      indexBuilder = std::make_unique<IndexBuilder>(formatContext->url, videoStreamIndex, audioStreamIndex,
+                                                    std::move(publish));
+      return;
     }
 
-    /* Find Audio Keyframes */
-    // Reset to beginning
-    av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
+    packets.build(formatContext, videoStreamIndex, audioStreamIndex);
 
-    auto keyFrame = keyFrameMap.begin();
-
-    while (av_read_frame(formatContext, &packet) >= 0)
+    if (fileKey)
     {
-      if (packet.stream_index == videoStreamIndex && packet.flags & AV_PKT_FLAG_KEY)
-      {
-        keyFrame->second = static_cast<int>(packet.pts);
-
-        ++keyFrame;
-      }
-      av_packet_unref(&packet);
+      packets.save(IndexCache::getCachePath(*fileKey, ".idx"), *fileKey);
     }
 
-    // Reset stream position
-    av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
+    publishIndex(std::move(packets), true);
   }
 
   void MediaParser::calculateTotalFrames()
   {
     validateVideoStream();
 
+    // The container metadata stands in for the index until it is complete, or if it has no video frames
     const AVStream* stream = formatContext->streams[videoStreamIndex];
 
     if (stream->nb_frames > 0)
     {
-      totalFrames = stream->nb_frames;
+      estimatedTotalFrames = stream->nb_frames;
     }
-
-    // Otherwise calculate based on duration and frame rate
-    if (stream->duration != AV_NOPTS_VALUE)
+    else if (stream->duration != AV_NOPTS_VALUE)
     {
-      const double frameRate = getFrameRate();
       const double durationSeconds = static_cast<double>(stream->duration) * av_q2d(stream->time_base);
-      totalFrames = static_cast<int>(durationSeconds * frameRate);
+      estimatedTotalFrames = static_cast<int>(durationSeconds * getFrameRate());
     }
+  }
 
-    // If metadata methods fail, count frames more efficiently by seeking to last keyframe
-    AVFormatContext* tempFormatCtx = nullptr;
-    if (avformat_open_input(&tempFormatCtx, formatContext->url, nullptr, nullptr) < 0)
-    {
-      throw std::runtime_error("Failed to open video file for frame counting!");
-    }
+  std::shared_ptr<const MediaParser::IndexSnapshot> MediaParser::getIndex() const
+  {
+    std::lock_guard lock(indexMutex);
 
-    if (avformat_find_stream_info(tempFormatCtx, nullptr) < 0)
-    {
-      avformat_close_input(&tempFormatCtx);
-      throw std::runtime_error("Failed to retrieve stream info for frame counting!");
-    }
+    return indexSnapshot;
+  }
 
-    // Find video stream index in temp context
-    int tempVideoStreamIndex = -1;
-    for (size_t i = 0; i < tempFormatCtx->nb_streams; i++)
+  void MediaParser::publishIndex(PacketIndex packets, const bool complete)
+  {
+    auto snapshot = std::make_shared<IndexSnapshot>();
+
+    std::unordered_map<int64_t, int64_t> keyFramePositions;
+    for (const auto& packet : packets.getPackets())
     {
-      if (tempFormatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+      if (packet.streamIndex == videoStreamIndex && packet.flags & AV_PKT_FLAG_KEY)
       {
-        tempVideoStreamIndex = static_cast<int>(i);
-        break;
+        keyFramePositions.emplace(packet.pts, packet.pos);
       }
     }
 
-    if (tempVideoStreamIndex == -1)
+    for (const auto& keyFrame : packets.getKeyFrames())
     {
-      avformat_close_input(&tempFormatCtx);
-      throw std::runtime_error("No video stream found for frame counting!");
-    }
-
-    // stream
-    const auto videoStream = tempFormatCtx->streams[tempVideoStreamIndex];
-
-    // Set up decoder for the video stream
-    const AVCodec* tempCodec = avcodec_find_decoder(videoStream->codecpar->codec_id);
-    AVCodecContext* tempCodecCtx = avcodec_alloc_context3(tempCodec);
-    avcodec_parameters_to_context(tempCodecCtx, videoStream->codecpar);
-
-    if (avcodec_open2(tempCodecCtx, tempCodec, nullptr) < 0)
-    {
-      avcodec_free_context(&tempCodecCtx);
-      avformat_close_input(&tempFormatCtx);
-      throw std::runtime_error("Failed to open codec for frame counting!");
-    }
-
-    // If we have keyframes, seek to the last known keyframe
-    int frameCount = 0;
-    if (!keyFrameMap.empty())
-    {
-      // Get the last keyframe position
-      const int lastKeyframe = keyFrameMap.rbegin()->first;
-      frameCount = lastKeyframe;
-
-      // Calculate PTS for the last keyframe
-      const int64_t targetPts = av_rescale_q(lastKeyframe,
-                                             AVRational{videoStream->avg_frame_rate.den, videoStream->avg_frame_rate.num},
-                                             videoStream->time_base) + videoStream->start_time;
-
-      // Seek to the last keyframe
-      if (av_seek_frame(tempFormatCtx, tempVideoStreamIndex, targetPts, AVSEEK_FLAG_BACKWARD) < 0)
-      {
-        avcodec_free_context(&tempCodecCtx);
-        avformat_close_input(&tempFormatCtx);
-        totalFrames = lastKeyframe; // Return last keyframe number if seek fails
-      }
+      snapshot->keyFrameMap[static_cast<int>(keyFrame.frame)] = keyFrame.pts;
 
-      // Flush buffers after seeking
-      avcodec_flush_buffers(tempCodecCtx);
+      const auto position = keyFramePositions.find(keyFrame.pts);
+      const int64_t pos = position != keyFramePositions.end() ? position->second : -1;
+      snapshot->keyFramePositions[static_cast<int>(keyFrame.frame)] = pos;
     }
 
-    // Allocate packet and frame
-    AVPacket* tempPacket = av_packet_alloc();
-    AVFrame* tempFrame = av_frame_alloc();
+    // A partial index ends right before the next GOP, the complete one keeps counting its frames like it always did
+    const uint32_t frameCount = packets.getVideoFrameCount();
+    snapshot->lastFrame = complete || frameCount == 0 ? frameCount : frameCount - 1;
+    snapshot->complete = complete;
+    snapshot->packets = std::move(packets);
 
-    // Count additional frames after the last keyframe
-    int additionalFrames = 0;
-    while (av_read_frame(tempFormatCtx, tempPacket) >= 0)
     {
-      if (tempPacket->stream_index == tempVideoStreamIndex)
-      {
-        if (avcodec_send_packet(tempCodecCtx, tempPacket) == 0)
-        {
-          while (avcodec_receive_frame(tempCodecCtx, tempFrame) == 0)
-          {
-            additionalFrames++;
-          }
-        }
-      }
-      av_packet_unref(tempPacket);
+      std::lock_guard lock(indexMutex);
+      indexSnapshot = std::move(snapshot);
     }
 
-    // Add additional frames to the count
-    frameCount += additionalFrames;
+    indexPublished.notify_all();
+
+    // The loader may be waiting at the end of the previous snapshot
+    wakeLoader();
+  }
 
-    // Clean up
-    av_frame_free(&tempFrame);
-    av_packet_free(&tempPacket);
-    avcodec_free_context(&tempCodecCtx);
-    avformat_close_input(&tempFormatCtx);
+  void MediaParser::waitForIndex()
+  {
+    // The constructor shows frame 1, so at least that far
+    std::unique_lock lock(indexMutex);
+    indexPublished.wait(lock, [this] {
+      return indexSnapshot && (indexSnapshot->complete || indexSnapshot->lastFrame >= 1);
+    });
+  }
 
-    totalFrames = frameCount;
+  void MediaParser::startThumbnails()
+  {
+    const auto index = getIndex();
+    const auto keyFrames = index->complete ? index->packets.getKeyFrames() : std::span<const KeyFrameEntry>();
+
+    // Thumbnails are only a nicety, keep most cores for playback
+    thumbnails = std::make_unique<ThumbnailGenerator>(formatContext->url, videoStreamIndex, getFrameWidth(),
+                                                      getFrameHeight(), keyFrames, fileKey,
+                                                      std::max(1u, std::thread::hardware_concurrency() / 4));
+    thumbnailsPending = !index->complete;
   }
 
   void MediaParser::setupAudio()
@@ -482,7 +908,7 @@ namespace AVParser {
     const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
     if (!codec)
     {
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to find decoder");
     }
 
@@ -490,7 +916,7 @@ namespace AVParser {
     audioCodecContext = avcodec_alloc_context3(codec);
     if (!audioCodecContext)
     {
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to allocate codec context");
     }
 
@@ -498,15 +924,18 @@ namespace AVParser {
     if (avcodec_parameters_to_context(audioCodecContext, codecParams) < 0)
     {
       avcodec_free_context(&audioCodecContext);
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to copy codec parameters to context");
     }
 
+    // Audio decoders only use slice threading, when they thread at all
+    applyDecoderParams(audioCodecContext, { .threadingMode = ThreadingMode::SLICE }, decoderParams.threadsPerDecoder);
+
     // Open codec
     if (avcodec_open2(audioCodecContext, codec, nullptr) < 0)
     {
       avcodec_free_context(&audioCodecContext);
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to open codec");
     }
 
@@ -515,7 +944,7 @@ namespace AVParser {
     if (!swrContext)
     {
       avcodec_free_context(&audioCodecContext);
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to allocate SwrContext");
     }
 
@@ -535,7 +964,7 @@ namespace AVParser {
     {
       swr_free(&swrContext);
       avcodec_free_context(&audioCodecContext);
-      avformat_close_input(&formatContext);
+      MediaInput::close(&formatContext);
       throw std::runtime_error("Failed to initialize SwrContext");
     }
   }
@@ -564,16 +993,12 @@ namespace AVParser {
     }
   }
 
-  void MediaParser::seekToFrame(const int64_t targetFrame) const
+  void MediaParser::seekToFrame(const IndexSnapshot& index, const int64_t targetFrame) const
   {
     validateVideoStream();
 
-    const AVStream* stream = formatContext->streams[videoStreamIndex];
-
-    // Calculate timestamp for the target frame
-    const int64_t targetPts = av_rescale_q(targetFrame,
-                              AVRational{stream->avg_frame_rate.den, stream->avg_frame_rate.num},
-                              stream->time_base) + stream->start_time;
+    // Exact timestamp of the target frame from the packet index
+    const int64_t targetPts = index.packets.getFramePts(static_cast<uint32_t>(targetFrame));
 
     // Seek to the nearest keyframe before the target
     if (av_seek_frame(formatContext, videoStreamIndex, targetPts, AVSEEK_FLAG_BACKWARD) < 0)
@@ -581,147 +1006,426 @@ namespace AVParser {
       throw std::runtime_error("Seek failed");
     }
 
-    // Flush the video decoder to clear internal buffers
-    avcodec_flush_buffers(videoCodecContext);
+    // Flush the audio decoder to clear internal buffers
     avcodec_flush_buffers(audioCodecContext);
   }
 
-  void MediaParser::loadFrame()
+  void MediaParser::loadFrameFromCache(const uint32_t targetFrame)
   {
-    if (frame == nullptr)
+    const auto index = getIndex();
+    const uint32_t targetKeyFrame = getKeyFrame(*index, targetFrame);
+
+    shownKeyFrame = targetKeyFrame;
+    missedFrame.reset();
+
+    if (takeReadyFrame(targetFrame))
+    {
+      return;
+    }
+
+    auto frames = videoCache.lookup(targetKeyFrame);
+    if (!frames)
     {
-      throw std::runtime_error("No video frame found!");
+      // Have the loader prefetch around the new position while this GOP is decoded
+      wakeLoader();
     }
 
-    if (packet == nullptr)
+    if (!frames && !decodePool->hasFailed(targetKeyFrame) && keepLoadingInBackground)
     {
-      throw std::runtime_error("No video packet found!");
+      // Jump the decode queue in case the background loader hasn't asked for this GOP yet
+      requestGop(*index, targetKeyFrame, true);
+
+      // About a frame interval, a GOP that is almost decoded is still shown right away. Waiting any longer would
+      // freeze the rendering, e.g. on a seek in a 4K file
+      const auto frameInterval = std::chrono::milliseconds(static_cast<int64_t>(1000.0 / getFrameRate()));
+      frames = videoCache.waitFor(targetKeyFrame, std::clamp(frameInterval, std::chrono::milliseconds(1),
+                                                             maxFrameWait));
     }
 
-    while (av_read_frame(formatContext, packet) >= 0)
+    if (!frames)
     {
-      if (packet->stream_index == videoStreamIndex)
+      // A GOP that can't be decoded is skipped, the frame on screen stays until the playhead reaches the next one.
+      // Any other is shown by update once it is decoded, as long as the playhead is still on it
+      if (!decodePool->hasFailed(targetKeyFrame))
       {
-        if (avcodec_send_packet(videoCodecContext, packet) == 0)
-        {
-          while (avcodec_receive_frame(videoCodecContext, frame) == 0)
-          {
-            convertVideoFrame();
-            av_packet_unref(packet);
-            return;
-          }
-        }
+        missedFrame = targetFrame;
       }
-      av_packet_unref(packet);
+
+      return;
+    }
+
+    // The GOP's data ended early, keep the last frame that could be decoded on screen
+    const auto relativeFrame = targetFrame - targetKeyFrame;
+    if (relativeFrame >= frames->size())
+    {
+      return;
     }
+
+    // Share the cached buffer, it goes back to the pool once the cache and the renderer have both let go of it
+    setCurrentVideoData(frames->at(relativeFrame), outputWidth, outputHeight);
   }
 
-  void MediaParser::convertVideoFrame() const
+  uint32_t MediaParser::getKeyFrame(const IndexSnapshot& index, const uint32_t frame)
   {
-    if (!frame->data[0])
+    const auto it = index.keyFrameMap.upper_bound(static_cast<int>(frame));
+    if (it == index.keyFrameMap.begin())
     {
-      throw std::runtime_error("Invalid frame data in convertVideoFrame");
+      throw std::runtime_error("Key frame not found!");
     }
 
-    const int outWidth = getFrameWidth();
-    const int outHeight = getFrameHeight();
+    return std::prev(it)->first;
+  }
+
+  void MediaParser::presentScrubFrame()
+  {
+    const uint32_t keyFrame = getKeyFrame(*getIndex(), currentFrame);
+
+    if (auto preview = scrubDecoder->find(keyFrame))
+    {
+      setCurrentVideoData(std::move(preview), scrubDecoder->getWidth(), scrubDecoder->getHeight());
+      shownKeyFrame = keyFrame;
+    }
+  }
 
-    // Resize or reallocate the buffer if needed
-    if (backgroundVideoData->size() != outWidth * outHeight * 4)
+  void MediaParser::waitForMissedFrame()
+  {
+    // Unlike the player thread, opening can afford to wait for its first frame
+    for (uint32_t waits = 0; missedFrame && waits < maxGopWaits && keepLoadingInBackground; waits++)
     {
-      backgroundVideoData->resize(outWidth * outHeight * 4);
+      const auto index = getIndex();
+      const uint32_t keyFrame = getKeyFrame(*index, *missedFrame);
+
+      if (decodePool->hasFailed(keyFrame))
+      {
+        missedFrame.reset();
+        return;
+      }
+
+      requestGop(*index, keyFrame, true);
+
+      if (videoCache.waitFor(keyFrame, gopWaitTimeout))
+      {
+        presentMissedFrame();
+      }
     }
+  }
+
+  void MediaParser::presentMissedFrame()
+  {
+    const uint32_t frame = *missedFrame;
 
-    uint8_t* dst[1] = { backgroundVideoData->data() };
-    const int dstStride[1] = { outWidth * 4 };
+    // Playback moved on and loaded the frames after it itself
+    if (frame != currentFrame)
+    {
+      missedFrame.reset();
+      return;
+    }
 
-    if (!swsContext)
+    const uint32_t keyFrame = getKeyFrame(*getIndex(), frame);
+    const auto frames = videoCache.lookup(keyFrame);
+    if (!frames)
     {
-      throw std::runtime_error("Invalid swsContext in convertVideoFrame");
+      return;
     }
 
-    sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+    missedFrame.reset();
+
+    if (frame - keyFrame < frames->size())
+    {
+      setCurrentVideoData(frames->at(frame - keyFrame), outputWidth, outputHeight);
+    }
   }
 
-  void MediaParser::loadFrameFromCache(const uint32_t targetFrame)
+  bool MediaParser::takeReadyFrame(const uint32_t targetFrame)
   {
-    bool found = false;
-    std::vector<unsigned char> data;
+    const bool reverse = state == MediaState::REVERSE_PLAYING;
 
-    while (!found)
+    while (ReadyFrame* frame = readyFrames.front())
     {
-      auto it = keyFrameMap.upper_bound(static_cast<int>(targetFrame));
-      if (it == keyFrameMap.begin())
+      const bool passed = reverse ? frame->frameIndex > targetFrame : frame->frameIndex < targetFrame;
+
+      if (frame->seekEpoch != seekEpoch || passed)
       {
-        throw std::runtime_error("Key frame not found!");
+        readyFrames.pop();
+        continue;
       }
-      --it;
-      const auto targetKeyFrame = it->first;
 
-      auto keyFrameIt = videoCache.find(targetKeyFrame);
-      if (keyFrameIt == videoCache.end())
+      if (frame->frameIndex != targetFrame)
       {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        continue;
+        return false;
+      }
+
+      setCurrentVideoData(std::move(frame->buffer), outputWidth, outputHeight);
+      readyFrames.pop();
+
+      return true;
+    }
+
+    return false;
+  }
+
+  void MediaParser::queueReadyFrames(const IndexSnapshot& index, const uint32_t playhead, const uint64_t epoch,
+                                     const bool reverse)
+  {
+    const int64_t step = reverse ? -1 : 1;
+
+    if (epoch != queuedEpoch || (nextQueuedFrame - playhead) * step <= 0)
+    {
+      nextQueuedFrame = playhead + step;
+      queuedEpoch = epoch;
+    }
+
+    std::shared_ptr<const FrameCache> frames;
+    uint32_t keyFrame = 0;
+
+    while (nextQueuedFrame >= 0 && nextQueuedFrame <= index.lastFrame && !readyFrames.full())
+    {
+      const auto frameIndex = static_cast<uint32_t>(nextQueuedFrame);
+
+      if (!frames || frameIndex < keyFrame || frameIndex >= getGopEnd(index, keyFrame))
+      {
+        keyFrame = getKeyFrame(index, frameIndex);
+        frames = videoCache.find(keyFrame);
       }
 
-      // Access the keyframe map from the cache
-      const auto& frames = keyFrameIt->second;
-      const auto relativeFrame = targetFrame - targetKeyFrame;
-      if (relativeFrame > frames.size())
+      const uint32_t relativeFrame = frameIndex - keyFrame;
+      if (!frames || relativeFrame >= frames->size())
       {
-        throw std::runtime_error("Target frame not found in key frame.");
+        // Not decoded yet, picked up again on the next pass
+        return;
       }
 
-      data = frames.at(relativeFrame);
-      found = true;
+      readyFrames.push({
+        .frameIndex = frameIndex,
+        .pts = index.packets.getFramePts(frameIndex),
+        .buffer = frames->at(relativeFrame),
+        .seekEpoch = epoch
+      });
+
+      nextQueuedFrame += step;
     }
+  }
+
+  void MediaParser::prefetchGops(const IndexSnapshot& index, std::map<int, int64_t>::const_iterator playing,
+                                 const bool reverse)
+  {
+    // Every worker gets a GOP, so the next one is decoded while the playing one is shown. Faster playback goes through
+    // the GOPs faster, so it looks further ahead
+    const auto rateFactor = static_cast<uint32_t>(std::ceil(std::max(playbackRate.load(), 1.0)));
+    const uint32_t depth = decodePool->getWorkerCount() * rateFactor;
+
+    size_t prefetchBytes = getGopBytes(index, playing->first);
+    for (uint32_t i = 0; i < depth; ++i)
+    {
+      if (reverse ? playing == index.keyFrameMap.begin() : std::next(playing) == index.keyFrameMap.end())
+      {
+        break;
+      }
 
-    // Set currentVideoData to the frame
-    currentVideoData = std::make_shared<std::vector<uint8_t>>(data);
+      playing = reverse ? std::prev(playing) : std::next(playing);
+
+      prefetchBytes += getGopBytes(index, playing->first);
+      if (prefetchBytes > videoCache.getByteBudget())
+      {
+        break;
+      }
+
+      requestGop(index, playing->first);
+
+      // The decoders are busy with the GOPs before it, read its packets meanwhile
+      prefetchGopData(index, playing->first);
+    }
   }
 
-  void MediaParser::loadFrames(const uint32_t targetFrame)
+  void MediaParser::syncAudio()
   {
-    auto it = keyFrameMap.upper_bound(static_cast<int>(targetFrame));
-    if (it == keyFrameMap.begin())
+    if (!audioNeedsSeek || !isAudible())
     {
-      throw std::runtime_error("Key frame not found!");
+      return;
+    }
+
+    audioRing.seek(getAudioSample(getIndex()->packets.getFrameTime(currentFrame)));
+    audioNeedsSeek = false;
+  }
+
+  bool MediaParser::isKeyFrameOnly() const
+  {
+    return (state == MediaState::AUTO_PLAYING || state == MediaState::REVERSE_PLAYING) &&
+           playbackRate >= keyFrameOnlyRate;
+  }
+
+  void MediaParser::presentKeyFrame()
+  {
+    ScrubDecoder& decoder = getFastPlaybackDecoder();
+
+    uint32_t keyFrame = getKeyFrame(*getIndex(), currentFrame);
+    FrameBuffer preview = decoder.find(keyFrame);
+
+    if (!preview)
+    {
+      // The decoder falls behind at high rates, show the keyframe closest to the due one it finished on the way there
+      // from the one on screen, never one behind it, e.g. from before a seek
+      auto [closestKeyFrame, closest] = decoder.findClosest(shownKeyFrame, keyFrame);
+      if (!closest)
+      {
+        return;
+      }
+
+      keyFrame = closestKeyFrame;
+      preview = std::move(closest);
+    }
+
+    if (preview != currentVideoData)
+    {
+      setCurrentVideoData(std::move(preview), decoder.getWidth(), decoder.getHeight());
+    }
+
+    shownKeyFrame = keyFrame;
+  }
+
+  void MediaParser::requestKeyFrames(const IndexSnapshot& index, const uint32_t frame, const bool reverse)
+  {
+    ScrubDecoder& decoder = getFastPlaybackDecoder();
+
+    const uint32_t keyFrame = getKeyFrame(index, frame);
+    decoder.request(keyFrame, index.keyFrameMap.at(static_cast<int>(keyFrame)));
+
+    // The faster the playback, the further apart the keyframes decoded ahead, so they stay ahead of the playhead even
+    // if the decoder can't keep up with every keyframe passed
+    const double lookAhead = keyFrameLookAheadSeconds * playbackRate;
+    const double time = index.packets.getFrameTime(frame);
+
+    std::vector<KeyFrameEntry> upcoming;
+    for (uint32_t i = 1; i <= keyFrameLookAhead; i++)
+    {
+      const double offset = lookAhead * i / keyFrameLookAhead;
+      const uint32_t due = std::min(index.packets.findFrame(reverse ? time - offset : time + offset), index.lastFrame);
+      const uint32_t next = getKeyFrame(index, due);
+
+      if (next != keyFrame && (upcoming.empty() || upcoming.back().frame != next))
+      {
+        upcoming.push_back({ .frame = next, .pts = index.keyFrameMap.at(static_cast<int>(next)) });
+      }
+    }
+
+    decoder.prefetch(std::move(upcoming));
+  }
+
+  ScrubDecoder& MediaParser::getFastPlaybackDecoder()
+  {
+    if (!fastPlaybackDecoder)
+    {
+      fastPlaybackDecoder = std::make_unique<ScrubDecoder>(formatContext->url, videoStreamIndex,
+                                                           decoderParams.frameFormat, outputWidth, outputHeight,
+                                                           fastPlaybackCacheSize);
+    }
+
+    return *fastPlaybackDecoder;
+  }
+
+  uint32_t MediaParser::getGopEnd(const IndexSnapshot& index, const uint32_t keyFrame)
+  {
+    const auto it = index.keyFrameMap.upper_bound(static_cast<int>(keyFrame));
+
+    return it == index.keyFrameMap.end() ? index.lastFrame + 1 : it->first;
+  }
+
+  void MediaParser::requestGop(const IndexSnapshot& index, const uint32_t keyFrame, const bool urgent)
+  {
+    const uint32_t frameCount = getGopEnd(index, keyFrame) - keyFrame;
+
+    decodePool->submit(keyFrame, index.keyFrameMap.at(static_cast<int>(keyFrame)), frameCount, urgent);
+  }
+
+  void MediaParser::prefetchGopData(const IndexSnapshot& index, const uint32_t keyFrame) const
+  {
+    const auto it = index.keyFramePositions.find(static_cast<int>(keyFrame));
+    if (it == index.keyFramePositions.end() || it->second < 0)
+    {
+      return;
+    }
+
+    // The last GOP runs to the end of the file, the prefetcher stops there
+    const auto next = std::next(it);
+    const int64_t end = next != index.keyFramePositions.end() ? next->second : std::numeric_limits<int64_t>::max();
+
+    readPrefetcher->prefetch(it->second, end);
+  }
+
+  size_t MediaParser::getGopBytes(const IndexSnapshot& index, const uint32_t keyFrame) const
+  {
+    return static_cast<size_t>(getGopEnd(index, keyFrame) - keyFrame) *
+           getFrameBytes(decoderParams.frameFormat, outputWidth, outputHeight);
+  }
+
+  int64_t MediaParser::getAudioSample(const double seconds) const
+  {
+    return std::llround(seconds * params.sampleRate);
+  }
+
+  void MediaParser::loadAudio(const IndexSnapshot& index, const uint32_t keyFrame)
+  {
+    // A seek discarded the buffered audio
+    if (const uint64_t resets = audioRing.getResetCount(); resets != audioRingResets)
+    {
+      audioGops.clear();
+      audioRingResets = resets;
     }
-    const auto nextKeyFrame = it == keyFrameMap.end() ? getTotalFrames() + 1 : it->first;
-    --it;
-    const auto targetKeyFrame = it->first;
 
-    FrameCache frameCache;
-    frameCache.reserve(nextKeyFrame - targetKeyFrame);
+    if (audioGops.contains(keyFrame))
+    {
+      return;
+    }
+
+    // Audio that starts after the video is preceded by silence, otherwise the ring has a gap it can't extend over
+    audioRing.padSilence(getAudioSample(index.packets.getAudioStartTime()));
 
-    seekToFrame(targetKeyFrame);
+    const uint32_t gopEnd = getGopEnd(index, keyFrame);
+    const bool lastGop = gopEnd >= index.lastFrame;
+    const double gopStartTime = index.packets.getFrameTime(keyFrame);
 
-    for (uint32_t i = targetKeyFrame; i < nextKeyFrame; ++i)
+    // Only decode once the GOP's audio joins the buffered audio and fits in front of the reader
+    const double gopDuration = static_cast<double>(gopEnd - keyFrame) / getFrameRate();
+    if (!audioRing.canExtend(getAudioSample(gopStartTime), getAudioSample(gopStartTime + gopDuration)))
     {
-      loadFrame();
-      frameCache.push_back(*backgroundVideoData);
+      return;
     }
 
-    videoCache[targetKeyFrame] = std::move(frameCache);
+    seekToFrame(index, keyFrame);
 
-    seekToFrame(targetKeyFrame);
+    // Decode the audio packets that play during this group of pictures, a partial index has the last GOP's audio too
+    const double gopEndTime = lastGop ? std::numeric_limits<double>::infinity() : index.packets.getFrameTime(gopEnd);
+    const uint32_t audioPackets = index.packets.countAudioPackets(gopStartTime, gopEndTime);
 
-    for (uint32_t i = targetKeyFrame; i < nextKeyFrame * 2; ++i)
+    for (uint32_t i = 0; i < audioPackets; ++i)
     {
       try
       {
         uint8_t* buffer = nullptr;
         int bufferSize = 0;
-        decodeAudioChunk(buffer, bufferSize);
+        decodeAudioChunk(index, buffer, bufferSize);
         av_freep(&buffer);
       }
       catch ([[maybe_unused]] const std::exception& e)
       { /* Some frames may not load but that's expected and OKAY. */ }
     }
+
+    audioGops.insert(keyFrame);
+
+    // Audio past the index may still follow the last GOP of a partial one
+    if (lastGop && index.complete)
+    {
+      audioEndResets = audioRingResets;
+    }
+  }
+
+  void MediaParser::evictAudio(const uint32_t keyFrame)
+  {
+    // The ring overwrites consumed samples by itself, only forget that the GOP was decoded
+    audioGops.erase(keyFrame);
   }
 
-  bool MediaParser::decodeAudioChunk(uint8_t*& outBuffer, int& outBufferSize)
+  bool MediaParser::decodeAudioChunk(const IndexSnapshot& index, uint8_t*& outBuffer, int& outBufferSize)
   {
     AVPacket* packet = av_packet_alloc();
     AVFrame* frame = av_frame_alloc();
@@ -804,8 +1508,12 @@ namespace AVParser {
             outBufferSize = samples_converted * params.channels * bytesPerSample;
             gotAudio = true;
 
-            // Cache
-            audioCache[frame->pts] = std::vector(outBuffer, outBuffer + outBufferSize);
+            // Place the samples by their timestamp, untimed chunks continue the buffered audio
+            const int64_t pts = frame->best_effort_timestamp;
+            const int64_t firstSample = pts != AV_NOPTS_VALUE ? getAudioSample(index.packets.getAudioTime(pts))
+                                                              : audioRing.getEndSample();
+
+            audioRing.write(firstSample, outBuffer, samples_converted);
 
             break;
           }
@@ -848,159 +1556,176 @@ namespace AVParser {
   {
     while (keepLoadingInBackground)
     {
-      // Get current frame and playback state
+      // Get current frame and playback state, the epoch is read first so it is never newer than the frame
+      const uint64_t epoch = seekEpoch;
       const uint32_t currentFrameIdx = currentFrame;
       const MediaState currentState = state;
 
+      // Read after the playhead, so it covers every frame the player clamped the playhead to
+      const auto index = getIndex();
+
+      updateAccessPattern(currentState);
+
+      // Previews are decoded on their own, the GOPs are only needed again once the scrub or the fast playback ends
+      if (scrubbing || isKeyFrameOnly())
+      {
+        waitForDemand();
+        continue;
+      }
+
       // Determine which keyframes to load based on playback direction
-      auto it = keyFrameMap.upper_bound(static_cast<int>(currentFrameIdx));
-      if (it == keyFrameMap.begin())
+      auto it = index->keyFrameMap.upper_bound(static_cast<int>(currentFrameIdx));
+      if (it == index->keyFrameMap.begin())
       {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        waitForDemand();
         continue;
       }
 
       --it;
 
-      // Load current keyframe's frames if not cached
-      if (const auto currentKeyFrame = it->first; !videoCache.contains(currentKeyFrame))
-      {
-        loadFrames(currentKeyFrame);
-      }
+      // The current GOP is decoded first, the pool works on the ones around it in parallel
+      const uint32_t currentKeyFrame = it->first;
+      requestGop(*index, currentKeyFrame, true);
+
+      const auto nextIt = std::next(it);
 
       // Determine next frames to preload based on playback state
-      if (currentState == MediaState::AUTO_PLAYING)
+      if (currentState == MediaState::AUTO_PLAYING || currentState == MediaState::REVERSE_PLAYING)
       {
-        // Preload next keyframe for forward playback
-        ++it;
-        if (it != keyFrameMap.end()) {
-          if (const auto nextKeyFrame = it->first; !videoCache.contains(nextKeyFrame))
-          {
-            loadFrames(nextKeyFrame);
-          }
-        }
+        // Keep every worker busy with the GOPs ahead in the playback direction, as far as the cache budget allows
+        const bool reverse = currentState == MediaState::REVERSE_PLAYING;
+
+        prefetchGops(*index, it, reverse);
+
+        queueReadyFrames(*index, currentFrameIdx, epoch, reverse);
       }
       else if (currentState == MediaState::MANUAL)
       {
         // For manual mode, preload both forward and backward
-        // First the next keyframe
-        auto tempIt = it;
-        ++tempIt;
-        if (tempIt != keyFrameMap.end())
+        if (nextIt != index->keyFrameMap.end())
         {
-          if (const auto nextKeyFrame = tempIt->first; !videoCache.contains(nextKeyFrame))
-          {
-            loadFrames(nextKeyFrame);
-          }
+          requestGop(*index, nextIt->first);
         }
 
-        // Then the previous keyframe
-        if (it != keyFrameMap.begin())
+        if (it != index->keyFrameMap.begin())
         {
-          --it;
-          if (const auto prevKeyFrame = it->first; !videoCache.contains(prevKeyFrame))
-          {
-            loadFrames(prevKeyFrame);
-          }
+          requestGop(*index, std::prev(it)->first);
         }
       }
 
-      // Smarter cache management - keep keyframes around current position
-      while (videoCache.size() > 4)
-      {
-        // Find the keyframe farthest from current position to remove
-        uint32_t farthestKeyFrame = 0;
-        int64_t maxDistance = -1;
+      // Audio is decoded here while the workers decode video
+      loadAudio(*index, currentKeyFrame);
 
-        for (const auto& cache : videoCache)
-        {
-          const int64_t distance = std::abs(static_cast<int64_t>(cache.first) - static_cast<int64_t>(currentFrameIdx));
-          if (distance > maxDistance)
-          {
-            maxDistance = distance;
-            farthestKeyFrame = cache.first;
-          }
-        }
+      const bool forward = currentState == MediaState::AUTO_PLAYING || currentState == MediaState::MANUAL;
 
-        if (maxDistance > 0)
-        {
-          const int chunks = videoCache.size();
+      if (forward && nextIt != index->keyFrameMap.end())
+      {
+        loadAudio(*index, nextIt->first);
+      }
 
-          for (int i = 0; i < chunks; ++i)
-          {
-            if (farthestKeyFrame > currentFrame)
-            {
-              audioCache.erase(std::prev(audioCache.end()));
-            }
-            else
-            {
-              audioCache.erase(audioCache.begin());
-              currentAudioChunk--;
-            }
-          }
+      if (currentState == MediaState::MANUAL && it != index->keyFrameMap.begin())
+      {
+        loadAudio(*index, std::prev(it)->first);
+      }
 
-          videoCache.erase(farthestKeyFrame);
-        }
-        else
-        {
-          break;
-        }
+      // Keep the decoded frames within the memory budget
+      PlaybackDirection direction = PlaybackDirection::NONE;
+      if (currentState == MediaState::AUTO_PLAYING)
+      {
+        direction = PlaybackDirection::FORWARD;
+      }
+      else if (currentState == MediaState::REVERSE_PLAYING)
+      {
+        direction = PlaybackDirection::BACKWARD;
+      }
+
+      for (const uint32_t evictedKeyFrame : videoCache.evict(currentFrameIdx, currentKeyFrame, direction))
+      {
+        evictAudio(evictedKeyFrame);
       }
+
+      // Nothing left to do until the playhead moves
+      waitForDemand();
+    }
+  }
+
+  void MediaParser::updateAccessPattern(const MediaState currentState)
+  {
+    AccessPattern pattern = AccessPattern::NORMAL;
+
+    if (scrubbing || isKeyFrameOnly() || currentState == MediaState::REVERSE_PLAYING)
+    {
+      // Only keyframes or GOPs in reverse order are read, read-ahead would fetch data that is skipped
+      pattern = AccessPattern::RANDOM;
+    }
+    else if (currentState == MediaState::AUTO_PLAYING)
+    {
+      pattern = AccessPattern::SEQUENTIAL;
+    }
+
+    if (pattern != accessPattern)
+    {
+      accessPattern = pattern;
+      MediaInput::setAccessPattern(formatContext->url, pattern);
+    }
+  }
+
+  void MediaParser::wakeLoader()
+  {
+    {
+      std::lock_guard lock(loaderMutex);
+      loaderSignalled = true;
     }
+
+    loaderWake.notify_one();
+  }
+
+  void MediaParser::waitForDemand()
+  {
+    std::unique_lock lock(loaderMutex);
+    loaderWake.wait(lock, [this] { return loaderSignalled; });
+    loaderSignalled = false;
+  }
+
+  void MediaParser::stopBackgroundLoader()
+  {
+    keepLoadingInBackground = false;
+    wakeLoader();
+
+    backgroundThread.join();
   }
 
   void MediaParser::setFilepath(const std::string& mediaFile)
   {
+    stopBackgroundLoader();
+
+    closeMedia();
+
     currentFrame = 0;
-    currentVideoData = std::make_shared<std::vector<uint8_t>>();
+    setCurrentVideoData(std::make_shared<std::vector<uint8_t>>(), 0, 0);
     currentAudioData = std::make_shared<std::vector<uint8_t>>();
     previousTime = std::chrono::steady_clock::now();
-    formatContext = nullptr;
-    videoCache.clear();
-    
-    frame = nullptr;
-    packet = nullptr;
-    swsContext = nullptr;
 
     videoCodec = nullptr;
-    videoCodecContext = nullptr;
-
     audioCodec = nullptr;
-    audioCodecContext = nullptr;
 
     videoStreamIndex = -1;
     audioStreamIndex = -1;
 
-    timeAccumulator = 0;
+    playbackClock = 0;
+    playbackStats = {};
+    missedFrame.reset();
 
     state = MediaState::AUTO_PLAYING;
 
-    keyFrameMap.clear();
-
-    totalFrames = 0;
-
-    if (avformat_open_input(&formatContext, mediaFile.c_str(), nullptr, nullptr) < 0)
-    {
-      throw std::runtime_error("Failed to open video file!");
-    }
-    if (avformat_find_stream_info(formatContext, nullptr) < 0)
-    {
-      throw std::runtime_error("Failed to retrieve stream info!");
-    }
-
-    findStreamIndices();
-
-    setupVideo();
-
-    setupAudio();
-
-    loadKeyframes();
+    estimatedTotalFrames = 0;
 
-    calculateTotalFrames();
+    openMedia(mediaFile);
 
-    frame = av_frame_alloc();
-    packet = av_packet_alloc();
+    keepLoadingInBackground = true;
+    backgroundThread = std::thread(&MediaParser::backgroundFrameLoader, this);
 
     loadNextFrame();
+    waitForMissedFrame();
   }
 } // AVParser
\ No newline at end of file
@@ -1,5 +1,17 @@
 #ifndef AVPARSER_H
 #define AVPARSER_H
+#include "AudioRingBuffer.h"
+#include "DecodePool.h"
+#include "GopCache.h"
+#include "IndexBuilder.h"
+#include "MediaInput.h"
+#include "PacketIndex.h"
+#include "ReadyFrameQueue.h"
+#include "ScrubDecoder.h"
+#include "ThumbnailGenerator.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 extern "C" {
@@ -12,8 +24,10 @@ extern "C" {
 #include <string>
 #include <memory>
 #include <chrono>
+#include <limits>
 #include <map>
-#include <unordered_map>
+#include <optional>
+#include <set>
 
 namespace AVParser {
 
@@ -22,14 +36,29 @@ struct AVFrameData {
   std::shared_ptr<std::vector<uint8_t>> audioData;
   int frameWidth;
   int frameHeight;
+  FrameFormat frameFormat = FrameFormat::RGBA;
+  ColorMatrix colorMatrix = ColorMatrix::BT709; // Only used by NV12 frames
+  bool fullRange = false;
 };
 
 enum class MediaState {
   AUTO_PLAYING,
+  REVERSE_PLAYING,
   PAUSED,
   MANUAL
 };
 
+enum class OpenMode {
+  INDEX_FIRST, // Index the whole file before the constructor returns
+  PROGRESSIVE  // Show the first frame right away and index the rest of the file in the background
+};
+
+struct PlaybackStats {
+  uint64_t droppedFrames = 0; // Frames skipped to catch up with the clock
+  uint64_t lateFrames = 0; // Frames shown more than half a frame after their time
+  double drift = 0; // Seconds the shown frame trails the playback clock
+};
+
 struct AudioParams {
   int sampleRate = 44100;
   int channels = 2;
@@ -39,7 +68,8 @@ struct AudioParams {
 
 class MediaParser {
 public:
-  MediaParser(const std::string& mediaFile, const AudioParams& params);
+  MediaParser(const std::string& mediaFile, const AudioParams& params, const DecoderParams& decoderParams = {},
+              OpenMode openMode = OpenMode::INDEX_FIRST);
 
   ~MediaParser();
 
@@ -47,38 +77,105 @@ public:
 
   [[nodiscard]] double getFrameRate() const;
 
+  // Estimated from the container until the index is complete
   [[nodiscard]] uint32_t getTotalFrames() const;
 
+  // Whether the whole file is indexed, a progressive open indexes it in the background
+  [[nodiscard]] bool isIndexComplete() const;
+
+  // Last frame that can be shown and seeked to yet, the same as getTotalFrames once the index is complete
+  [[nodiscard]] uint32_t getIndexedFrames() const;
+
   [[nodiscard]] uint32_t getCurrentFrameIndex() const;
 
+  // Whether the playhead is on the last frame of the completely indexed file, e.g. once playback finished
+  [[nodiscard]] bool isAtEnd() const;
+
   void loadNextFrame();
 
   void loadPreviousFrame();
 
   void loadFrameAt(uint32_t targetFrame);
 
+  // Advances playback on the system clock
   void update();
 
+  // Advances playback on the audio clock, queuedAudioBytes of the audio from getNextAudioChunk were handed on but not
+  // heard yet. Counted before any time-stretching, e.g. the bytes queued on the device times the rate
+  void update(int queuedAudioBytes);
+
   void play();
 
+  // Plays backwards from the current frame without audio, the GOPs before the playhead are decoded ahead
+  void playReverse();
+
   void pause();
 
   void setManual(bool manual);
 
   [[nodiscard]] MediaState getState() const;
 
-  bool getNextAudioChunk(uint8_t*& outBuffer, int& outBufferSize);
+  // Speed of playback in either direction, clamped to 0.25x - 64x. From 8x on only keyframes are decoded and shown
+  void setPlaybackRate(double rate);
+
+  [[nodiscard]] double getPlaybackRate() const;
+
+  // Whether the audio plays along at the current direction and rate, forwards from 0.5x to 3x. The audio isn't
+  // stretched here, away from 1x the caller has to change its speed without changing its pitch
+  [[nodiscard]] bool isAudible() const;
+
+  // Shows downscaled keyframe previews instead of decoding whole GOPs, for dragging the timeline
+  void beginScrub();
+
+  // Moves the playhead, the preview of the closest keyframe before it is shown once it is decoded
+  void scrubTo(uint32_t targetFrame);
+
+  // Loads the exact frame the scrub ended on and restores the state from before the scrub
+  void endScrub();
+
+  [[nodiscard]] bool isScrubbing() const;
+
+  // Decodes frames scaled down to fit width x height, e.g. the size the video is shown at. 0 decodes at the video's own
+  // size. Small changes are ignored, the renderer scales the frames the rest of the way
+  void setOutputSize(int width, int height);
+
+  // Points outBuffer at the next decoded audio without copying it, valid until the next call
+  bool getNextAudioChunk(const uint8_t*& outBuffer, int& outBufferSize);
+
+  // Whether getNextAudioChunk handed out the file's audio up to its end, so whatever plays next can be queued behind it
+  [[nodiscard]] bool isAudioFinished() const;
+
+  [[nodiscard]] CacheStats getCacheStats() const;
+
+  [[nodiscard]] PlaybackStats getPlaybackStats() const;
+
+  // Keyframe thumbnails for the timeline, decoded in the background once the file is indexed
+  [[nodiscard]] const ThumbnailGenerator& getThumbnails() const;
 
   void setFilepath(const std::string& mediaFile);
 
 private:
+  // The packet index and what is derived from it. Replaced as a whole while a progressive open indexes the file, every
+  // GOP in it is complete and a newer one only adds frames after them
+  struct IndexSnapshot {
+    PacketIndex packets;
+    std::map<int, int64_t> keyFrameMap;
+
+    // Byte position of every keyframe's packet, -1 if the container doesn't say
+    std::map<int, int64_t> keyFramePositions;
+
+    // Last frame that can be shown. Once complete this is the frame count, like getTotalFrames always was
+    uint32_t lastFrame = 0;
+    bool complete = false;
+  };
+
   AVFormatContext* formatContext = nullptr;
-  AVFrame* frame = nullptr;
-  AVPacket* packet = nullptr;
 
   const AVCodec* videoCodec = nullptr;
   AVCodecContext* videoCodecContext = nullptr;
-  SwsContext* swsContext = nullptr;
+
+  ColorMatrix colorMatrix = ColorMatrix::BT709;
+  bool fullRange = false;
 
   const AVCodec* audioCodec = nullptr;
   AVCodecContext* audioCodecContext = nullptr;
@@ -87,45 +184,146 @@ private:
   int videoStreamIndex = -1;
   int audioStreamIndex = -1;
 
-  uint32_t currentFrame;
+  // Written by the player thread, read by the background loader
+  std::atomic<uint32_t> currentFrame;
 
   std::shared_ptr<std::vector<uint8_t>> currentVideoData;
   std::shared_ptr<std::vector<uint8_t>> currentAudioData;
 
-  std::shared_ptr<std::vector<uint8_t>> backgroundVideoData;
-
-  float timeAccumulator = 0;
   std::chrono::time_point<std::chrono::steady_clock> previousTime;
 
-  MediaState state = MediaState::AUTO_PLAYING;
+  // Media time that should be on screen, relative to the first frame
+  double playbackClock = 0;
+  PlaybackStats playbackStats;
+
+  std::atomic<MediaState> state = MediaState::AUTO_PLAYING;
+  std::atomic<double> playbackRate = 1.0;
+
+  OpenMode openMode;
+
+  // Read with getIndex, the player thread and the background loader each keep the snapshot they started working with
+  mutable std::mutex indexMutex;
+  std::condition_variable indexPublished;
+  std::shared_ptr<const IndexSnapshot> indexSnapshot;
+
+  // Identifies the file in the on disk caches, empty if it couldn't be read
+  std::optional<IndexCache::MediaFileKey> fileKey;
+
+  // Declared before the cache and the workers so it outlives every decode into it
+  FrameBufferPool framePool;
+  GopCache videoCache;
+  std::unique_ptr<DecodePool> decodePool;
+  std::unique_ptr<ReadPrefetcher> readPrefetcher;
+
+  // Frames ahead of the playhead, pushed by the background loader and taken by the player thread
+  ReadyFrameQueue readyFrames;
+  std::atomic<uint64_t> seekEpoch = 0;
+
+  std::unique_ptr<ScrubDecoder> scrubDecoder;
+
+  // Decodes the keyframes of keyframe only playback at the output size, created when that playback starts
+  std::unique_ptr<ScrubDecoder> fastPlaybackDecoder;
+  std::unique_ptr<ThumbnailGenerator> thumbnails;
+
+  // Set until the thumbnails are started for the complete index
+  bool thumbnailsPending = false;
+  std::atomic<bool> scrubbing = false;
+  MediaState stateBeforeScrub = MediaState::PAUSED;
+
+  // Read-ahead hint last given for the file, only touched by the background loader
+  AccessPattern accessPattern = AccessPattern::NORMAL;
+
+  // Set when frames were shown without their audio (in reverse or too fast or slow), until the audio is moved back
+  bool audioNeedsSeek = false;
+
+  // GOP of the frame on screen, keyframe only playback never shows a keyframe behind it
+  uint32_t shownKeyFrame = 0;
+
+  // Frame whose GOP wasn't decoded in time, shown once it is if the playhead is still on it
+  std::optional<uint32_t> missedFrame;
+
+  // Size asked for with setOutputSize, 0 for the video's own size
+  int requestedOutputWidth = 0;
+  int requestedOutputHeight = 0;
 
-  std::map<int, int> keyFrameMap;
+  // Size the GOPs are decoded at, read by the background loader for the cache budget
+  std::atomic<int> outputWidth = 0;
+  std::atomic<int> outputHeight = 0;
 
-  using FrameCache = std::vector<std::vector<uint8_t>>;
-  std::unordered_map<uint32_t, FrameCache> videoCache;
+  // Size of currentVideoData, a scrub preview or a frame decoded before the output size changed differ from outputWidth
+  int currentVideoWidth = 0;
+  int currentVideoHeight = 0;
 
-  uint32_t totalFrames = 0;
+  // Next frame the loader queues and the seek epoch it was queued for, only touched by the loader. Signed so reverse
+  // playback can go past frame 0
+  int64_t nextQueuedFrame = 0;
+  uint64_t queuedEpoch = 0;
+
+  // Frame count from the container, used as the duration until the index is complete
+  uint32_t estimatedTotalFrames = 0;
 
   AudioParams params;
 
-  std::map<uint32_t, std::vector<uint8_t>> audioCache;
-  uint32_t currentAudioChunk = 0;
+  DecoderParams decoderParams;
+
+  AudioRingBuffer audioRing;
+
+  // Key frames of the GOPs whose audio is in audioRing, valid while its reset count matches audioRingResets
+  std::set<uint32_t> audioGops;
+  uint64_t audioRingResets = 0;
+
+  // Reset count of audioRing when the audio up to the end of the file was decoded into it, none while it isn't
+  static constexpr uint64_t noAudioEnd = std::numeric_limits<uint64_t>::max();
+  std::atomic<uint64_t> audioEndResets = noAudioEnd;
 
   std::atomic<bool> keepLoadingInBackground = true;
   std::thread backgroundThread;
 
+  // Set when the playhead or the state changed, the background loader sleeps until then
+  std::mutex loaderMutex;
+  std::condition_variable loaderWake;
+  bool loaderSignalled = false;
+
+  // Indexes the file in the background after a progressive open. Declared last so it stops before the members it
+  // publishes into are destroyed
+  std::unique_ptr<IndexBuilder> indexBuilder;
+
+  void openMedia(const std::string& mediaFile);
+
+  void closeMedia();
+
   [[nodiscard]] int getFrameWidth() const;
 
   [[nodiscard]] int getFrameHeight() const;
 
+  // The requested output size fitted to the video, rounded down to even dimensions for NV12
+  [[nodiscard]] std::pair<int, int> getFittedOutputSize() const;
+
+  // Sets the size the GOPs are decoded at and decodes the current frame again at that size
+  void applyOutputSize(int width, int height);
+
+  void setCurrentVideoData(FrameBuffer buffer, int width, int height);
+
   void findStreamIndices();
 
   void setupVideo();
 
+  // Loads or builds the packet index, or starts building it in the background for a progressive open
   void loadKeyframes();
 
   void calculateTotalFrames();
 
+  [[nodiscard]] std::shared_ptr<const IndexSnapshot> getIndex() const;
+
+  // Replaces the index snapshot, called by the IndexBuilder as it gets through the file
+  void publishIndex(PacketIndex packets, bool complete);
+
+  // Blocks until the first frames are indexed
+  void waitForIndex();
+
+  // Starts decoding the thumbnails once the index is complete, over a partial index they would bunch up at the start
+  void startThumbnails();
+
   void setupAudio();
 
   void validateVideoContext() const;
@@ -134,17 +332,80 @@ private:
 
   void validateAudioStream() const;
 
-  void seekToFrame(int64_t targetFrame) const;
+  void seekToFrame(const IndexSnapshot& index, int64_t targetFrame) const;
 
-  void loadFrame();
+  void loadFrameFromCache(uint32_t targetFrame);
 
-  void convertVideoFrame() const;
+  [[nodiscard]] static uint32_t getKeyFrame(const IndexSnapshot& index, uint32_t frame);
 
-  void loadFrameFromCache(uint32_t targetFrame);
+  // Shows the preview of the playhead's keyframe if it is decoded
+  void presentScrubFrame();
+
+  // Shows the frame loadFrameFromCache gave up waiting for if its GOP was decoded since
+  void presentMissedFrame();
+
+  // Waits a bounded time for the GOP of the missed frame and shows it, used when a file is opened
+  void waitForMissedFrame();
+
+  // Takes the frame from the ready queue if the loader already prepared it, dropping the frames queued before it in the
+  // playback direction
+  bool takeReadyFrame(uint32_t targetFrame);
+
+  // Queues the decoded frames after the playhead (before it when reversing) until the queue is full or a GOP isn't
+  // decoded yet
+  void queueReadyFrames(const IndexSnapshot& index, uint32_t playhead, uint64_t epoch, bool reverse);
+
+  // Requests the GOPs after the playing one (before it when reversing) for every worker, within the cache budget
+  void prefetchGops(const IndexSnapshot& index, std::map<int, int64_t>::const_iterator playing, bool reverse);
+
+  // Moves the audio back to the playhead once frames were shown without it
+  void syncAudio();
+
+  // Whether playback is fast enough that only keyframes are shown
+  [[nodiscard]] bool isKeyFrameOnly() const;
+
+  // Shows the keyframe before the playhead, or the closest one to it the decoder finished on the way there
+  void presentKeyFrame();
+
+  // Has the keyframe before the frame decoded first and the ones playback reaches next at this rate after it
+  void requestKeyFrames(const IndexSnapshot& index, uint32_t frame, bool reverse);
+
+  [[nodiscard]] ScrubDecoder& getFastPlaybackDecoder();
+
+  // Media seconds since the last update, negative in reverse and scaled by the rate. nullopt (and the clock
+  // re-anchored to the current frame) when not playing
+  [[nodiscard]] std::optional<double> advanceTime();
+
+  // Jumps straight to the frame due at playbackClock, the frames in between are dropped without being loaded
+  void presentDueFrame();
+
+  [[nodiscard]] static uint32_t getGopEnd(const IndexSnapshot& index, uint32_t keyFrame);
+
+  void requestGop(const IndexSnapshot& index, uint32_t keyFrame, bool urgent = false);
+
+  // Has the prefetcher read the GOP's packets, from its keyframe up to the next one
+  void prefetchGopData(const IndexSnapshot& index, uint32_t keyFrame) const;
+
+  [[nodiscard]] size_t getGopBytes(const IndexSnapshot& index, uint32_t keyFrame) const;
+
+  // Audio sample at the given time. Like the PacketIndex times it counts from the start of the file, the earlier of
+  // the first frame and the first audio packet, the ring holds silence before audio that starts later
+  [[nodiscard]] int64_t getAudioSample(double seconds) const;
+
+  void loadAudio(const IndexSnapshot& index, uint32_t keyFrame);
+
+  void evictAudio(uint32_t keyFrame);
+
+  bool decodeAudioChunk(const IndexSnapshot& index, uint8_t*& outBuffer, int& outBufferSize);
+
+  // Lets the OS read ahead while playing forwards, but not while jumping around the file
+  void updateAccessPattern(MediaState currentState);
+
+  void wakeLoader();
 
-  void loadFrames(uint32_t targetFrame);
+  void waitForDemand();
 
-  bool decodeAudioChunk(uint8_t*& outBuffer, int& outBufferSize);
+  void stopBackgroundLoader();
 
   void backgroundFrameLoader();
 };
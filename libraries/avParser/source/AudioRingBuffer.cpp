@@ -0,0 +1,192 @@
+#include "AudioRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace AVParser {
+  // Gaps up to this many samples between chunks are closed, resampling and PTS rounding leave a few
+  constexpr int64_t snapFrames = 32;
+
+  AudioRingBuffer::AudioRingBuffer(const size_t capacityFrames, const size_t bytesPerFrame)
+    : samples(capacityFrames * bytesPerFrame), capacity(static_cast<int64_t>(capacityFrames)),
+      bytesPerFrame(bytesPerFrame)
+  {}
+
+  bool AudioRingBuffer::write(int64_t firstSample, const uint8_t* data, size_t frameCount)
+  {
+    // Samples before the start of the stream can't be addressed
+    if (firstSample < 0)
+    {
+      const size_t skipped = std::min(static_cast<size_t>(-firstSample), frameCount);
+      data += skipped * bytesPerFrame;
+      frameCount -= skipped;
+      firstSample = 0;
+    }
+
+    if (frameCount == 0)
+    {
+      return false;
+    }
+
+    std::lock_guard lock(mutex);
+
+    const auto frames = static_cast<int64_t>(frameCount);
+    const int64_t lastSample = firstSample + frames;
+
+    bool stored = false;
+
+    // Frames before the range, e.g. from a keyframe ahead of a seek target. The closest ones are kept if they
+    // don't all fit, and a small gap is closed by placing them right before the range
+    if (firstSample < start && lastSample + snapFrames >= start)
+    {
+      const int64_t before = std::min(start - firstSample, frames);
+      const int64_t count = std::min(before, capacity - (end - start));
+
+      if (count > 0)
+      {
+        copyIn(start - count, data + (before - count) * bytesPerFrame, count);
+        start -= count;
+        stored = true;
+      }
+    }
+
+    // Frames after the range, skipping the ones already buffered
+    if (lastSample > end && firstSample <= end + snapFrames)
+    {
+      const int64_t skipped = std::max<int64_t>(end - firstSample, 0);
+      const int64_t count = frames - skipped;
+
+      if (end + count - retainedSample > capacity)
+      {
+        return stored;
+      }
+
+      copyIn(end, data + skipped * bytesPerFrame, count);
+      end += count;
+      start = std::max(start, end - capacity);
+      stored = true;
+    }
+
+    return stored;
+  }
+
+  void AudioRingBuffer::padSilence(const int64_t untilSample)
+  {
+    std::lock_guard lock(mutex);
+
+    const int64_t count = untilSample - end;
+    if (count <= 0 || end + count - retainedSample > capacity)
+    {
+      return;
+    }
+
+    zeroFill(end, count);
+    end += count;
+    start = std::max(start, end - capacity);
+  }
+
+  bool AudioRingBuffer::canExtend(int64_t firstSample, const int64_t lastSample) const
+  {
+    firstSample = std::max<int64_t>(firstSample, 0);
+
+    std::lock_guard lock(mutex);
+
+    if (lastSample <= firstSample || (firstSample >= start && lastSample <= end))
+    {
+      return false;
+    }
+
+    if (firstSample > end + snapFrames || lastSample + snapFrames < start)
+    {
+      return false;
+    }
+
+    const int64_t appended = std::max<int64_t>(lastSample - std::max(firstSample, end), 0);
+
+    return end + std::min(appended, capacity) - retainedSample <= capacity;
+  }
+
+  std::span<const uint8_t> AudioRingBuffer::read(const size_t maxFrames)
+  {
+    std::lock_guard lock(mutex);
+
+    retainedSample = readSample;
+
+    const int64_t offset = readSample % capacity;
+    const int64_t count = std::min({ end - readSample, capacity - offset, static_cast<int64_t>(maxFrames) });
+
+    if (count <= 0)
+    {
+      return {};
+    }
+
+    readSample += count;
+
+    return { samples.data() + offset * bytesPerFrame, static_cast<size_t>(count) * bytesPerFrame };
+  }
+
+  void AudioRingBuffer::seek(const int64_t sample)
+  {
+    std::lock_guard lock(mutex);
+
+    if (sample < start || sample > end)
+    {
+      reset(std::max<int64_t>(sample, 0));
+      return;
+    }
+
+    readSample = sample;
+    retainedSample = sample;
+  }
+
+  void AudioRingBuffer::clear()
+  {
+    std::lock_guard lock(mutex);
+    reset(0);
+  }
+
+  int64_t AudioRingBuffer::getReadSample() const
+  {
+    std::lock_guard lock(mutex);
+    return readSample;
+  }
+
+  int64_t AudioRingBuffer::getEndSample() const
+  {
+    std::lock_guard lock(mutex);
+    return end;
+  }
+
+  uint64_t AudioRingBuffer::getResetCount() const
+  {
+    std::lock_guard lock(mutex);
+    return resets;
+  }
+
+  void AudioRingBuffer::reset(const int64_t sample)
+  {
+    start = sample;
+    end = sample;
+    readSample = sample;
+    retainedSample = sample;
+    resets++;
+  }
+
+  void AudioRingBuffer::copyIn(const int64_t sample, const uint8_t* data, const int64_t frameCount)
+  {
+    // Split the copy where it wraps around the end of the ring
+    const int64_t offset = sample % capacity;
+    const int64_t firstPart = std::min(frameCount, capacity - offset);
+
+    std::memcpy(samples.data() + offset * bytesPerFrame, data, firstPart * bytesPerFrame);
+    std::memcpy(samples.data(), data + firstPart * bytesPerFrame, (frameCount - firstPart) * bytesPerFrame);
+  }
+
+  void AudioRingBuffer::zeroFill(const int64_t sample, const int64_t frameCount)
+  {
+    const int64_t offset = sample % capacity;
+    const int64_t firstPart = std::min(frameCount, capacity - offset);
+
+    std::memset(samples.data() + offset * bytesPerFrame, 0, firstPart * bytesPerFrame);
+    std::memset(samples.data(), 0, (frameCount - firstPart) * bytesPerFrame);
+  }
+} // AVParser
@@ -0,0 +1,73 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace AVParser {
+
+// Decoded PCM in one contiguous ring, addressed by the sample number since the start of the stream. Holds a single
+// range of samples that grows forwards as audio is decoded and drops samples the reader has already consumed
+class AudioRingBuffer {
+public:
+  AudioRingBuffer(size_t capacityFrames, size_t bytesPerFrame);
+
+  // Stores interleaved frames starting at firstSample. Only the part that extends the buffered range is kept, returns
+  // false if nothing was stored because the frames don't touch the range or would overwrite unread samples
+  bool write(int64_t firstSample, const uint8_t* data, size_t frameCount);
+
+  // Extends the buffered range with silence up to untilSample, e.g. before a stream that starts after the video.
+  // Does nothing if the range already reaches it or the silence would overwrite unread samples
+  void padSilence(int64_t untilSample);
+
+  // Whether writing [firstSample, lastSample) would extend the buffered range without overwriting unread samples
+  [[nodiscard]] bool canExtend(int64_t firstSample, int64_t lastSample) const;
+
+  // Returns up to maxFrames from the read position without copying and advances it. The span is never wrapped and
+  // stays valid until the next read or seek
+  [[nodiscard]] std::span<const uint8_t> read(size_t maxFrames);
+
+  // Moves the read position, the buffered samples are kept if the position is inside them
+  void seek(int64_t sample);
+
+  void clear();
+
+  [[nodiscard]] int64_t getReadSample() const;
+
+  // One past the last buffered sample
+  [[nodiscard]] int64_t getEndSample() const;
+
+  // Incremented whenever the buffered samples are discarded
+  [[nodiscard]] uint64_t getResetCount() const;
+
+private:
+  mutable std::mutex mutex;
+
+  std::vector<uint8_t> samples;
+
+  int64_t capacity;
+  size_t bytesPerFrame;
+
+  // Buffered range [start, end)
+  int64_t start = 0;
+  int64_t end = 0;
+
+  int64_t readSample = 0;
+
+  // Start of the span handed out by the last read, nothing from here on is overwritten
+  int64_t retainedSample = 0;
+
+  uint64_t resets = 0;
+
+  void reset(int64_t sample);
+
+  void copyIn(int64_t sample, const uint8_t* data, int64_t frameCount);
+
+  void zeroFill(int64_t sample, int64_t frameCount);
+};
+
+} // AVParser
+
+#endif //AUDIORINGBUFFER_H
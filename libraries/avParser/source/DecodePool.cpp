@@ -0,0 +1,215 @@
+#include "DecodePool.h"
+#include <algorithm>
+#include <thread>
+
+namespace AVParser {
+  // GOPs are decoded by at most this many workers when the count is picked automatically
+  constexpr uint32_t maxDecodeWorkers = 4;
+
+  // Decodes of one GOP that have to fail before it is given up on, a read may fail only transiently
+  constexpr uint32_t maxDecodeAttempts = 3;
+
+  DecodePool::DecodePool(const std::string& mediaFile, const int videoStreamIndex, GopCache& cache,
+                         FrameBufferPool& framePool, const DecoderParams& params)
+    : cache(cache), scheduler(DecodeScheduler::getShared())
+  {
+    const uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+    decoderCount = params.decodeWorkers > 0 ? params.decodeWorkers : std::clamp(cores / 2, 1u, maxDecodeWorkers);
+
+    // Split the cores between the scheduler's workers, not this file's decoders, so frame threading doesn't
+    // oversubscribe the CPU however many files are open
+    const int threadCount = params.threadsPerDecoder > 0
+                              ? params.threadsPerDecoder
+                              : static_cast<int>(std::max(cores / scheduler.getWorkerCount(), 1u));
+
+    // Open every decoder up front so a file that can't be decoded fails here instead of on a worker
+    for (uint32_t i = 0; i < decoderCount; i++)
+    {
+      idleDecoders.push_back(std::make_unique<GopDecoder>(mediaFile, videoStreamIndex, params, threadCount,
+                                                          framePool));
+    }
+  }
+
+  DecodePool::~DecodePool()
+  {
+    // Tasks still decoding finish first, they publish into the cache and return their decoder
+    scheduler.cancel(this);
+  }
+
+  void DecodePool::submit(const uint32_t keyFrame, const int64_t keyFramePts, const uint32_t frameCount,
+                          const bool urgent)
+  {
+    std::lock_guard lock(mutex);
+
+    if (pending.contains(keyFrame))
+    {
+      if (urgent)
+      {
+        // Move it to the front if no task has picked it up yet
+        const auto it = std::ranges::find(jobs, keyFrame, &DecodeJob::keyFrame);
+        if (it != jobs.end())
+        {
+          const DecodeJob job = *it;
+          jobs.erase(it);
+          jobs.push_front(job);
+
+          scheduleJobs(true);
+        }
+      }
+
+      return;
+    }
+
+    if (cache.contains(keyFrame) || hasFailedLocked(keyFrame))
+    {
+      return;
+    }
+
+    const DecodeJob job {
+      .keyFrame = keyFrame,
+      .keyFramePts = keyFramePts,
+      .frameCount = frameCount
+    };
+
+    if (urgent)
+    {
+      jobs.push_front(job);
+    }
+    else
+    {
+      jobs.push_back(job);
+    }
+
+    pending.insert(keyFrame);
+
+    scheduleJobs(urgent);
+  }
+
+  void DecodePool::cancelPending()
+  {
+    std::lock_guard lock(mutex);
+
+    for (const auto& job : jobs)
+    {
+      pending.erase(job.keyFrame);
+    }
+
+    jobs.clear();
+  }
+
+  void DecodePool::setOutputSize(const int width, const int height)
+  {
+    std::lock_guard lock(mutex);
+
+    outputWidth = width;
+    outputHeight = height;
+
+    // Jobs queued or in flight are for the old size, workers drop what they finish
+    jobs.clear();
+    pending.clear();
+  }
+
+  uint32_t DecodePool::getWorkerCount() const
+  {
+    return decoderCount;
+  }
+
+  bool DecodePool::hasFailed(const uint32_t keyFrame)
+  {
+    std::lock_guard lock(mutex);
+    return hasFailedLocked(keyFrame);
+  }
+
+  bool DecodePool::hasFailedLocked(const uint32_t keyFrame) const
+  {
+    const auto it = failures.find(keyFrame);
+    return it != failures.end() && it->second >= maxDecodeAttempts;
+  }
+
+  void DecodePool::scheduleJobs(const bool urgent)
+  {
+    // The urgent job is at the front, a task of its own lets it pass the other files' prefetching
+    if (urgent && !urgentTaskQueued)
+    {
+      scheduler.submit(this, DecodePriority::PLAYHEAD, [this] { runJob(true); });
+      urgentTaskQueued = true;
+      queuedTasks++;
+    }
+
+    const size_t wanted = std::min(jobs.size(), idleDecoders.size());
+    while (queuedTasks < wanted)
+    {
+      scheduler.submit(this, DecodePriority::PREFETCH, [this] { runJob(false); });
+      queuedTasks++;
+    }
+  }
+
+  void DecodePool::runJob(const bool urgentTask)
+  {
+    DecodeJob job{};
+    std::unique_ptr<GopDecoder> decoder;
+    int width;
+    int height;
+
+    {
+      std::lock_guard lock(mutex);
+
+      queuedTasks--;
+      if (urgentTask)
+      {
+        urgentTaskQueued = false;
+      }
+
+      // Cancelled, or taken by a task that ran first. A busy decoder schedules the job again once it is done
+      if (jobs.empty() || idleDecoders.empty())
+      {
+        return;
+      }
+
+      job = jobs.front();
+      jobs.pop_front();
+
+      decoder = std::move(idleDecoders.back());
+      idleDecoders.pop_back();
+
+      width = outputWidth;
+      height = outputHeight;
+    }
+
+    FrameCache frames;
+    bool decoded = false;
+    try
+    {
+      decoder->setOutputSize(width, height);
+      frames = decoder->decode(job.keyFramePts, job.frameCount);
+
+      // A GOP without a single decodable frame is a failure too, caching it would make it permanent
+      decoded = !frames.empty();
+    }
+    catch ([[maybe_unused]] const std::exception& e)
+    { /* Counted below, readers keep the frame they have until a retry succeeds or the GOP is given up on */ }
+
+    std::lock_guard lock(mutex);
+
+    idleDecoders.push_back(std::move(decoder));
+
+    // The output size changed while decoding, the GOP was requested again at the new size
+    if (width == outputWidth && height == outputHeight)
+    {
+      if (decoded)
+      {
+        cache.insert(job.keyFrame, std::move(frames));
+        failures.erase(job.keyFrame);
+      }
+      else
+      {
+        failures[job.keyFrame]++;
+      }
+
+      pending.erase(job.keyFrame);
+    }
+
+    scheduleJobs(false);
+  }
+} // AVParser
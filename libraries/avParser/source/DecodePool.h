@@ -0,0 +1,87 @@
+#ifndef DECODEPOOL_H
+#define DECODEPOOL_H
+
+#include "DecodeScheduler.h"
+#include "GopCache.h"
+#include "GopDecoder.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace AVParser {
+
+// Decodes independent GOPs in parallel on the shared DecodeScheduler and publishes them into a GopCache. Urgent GOPs
+// run at playhead priority, the rest at prefetch priority
+class DecodePool {
+public:
+  DecodePool(const std::string& mediaFile, int videoStreamIndex, GopCache& cache, FrameBufferPool& framePool,
+             const DecoderParams& params);
+
+  ~DecodePool();
+
+  DecodePool(const DecodePool&) = delete;
+  DecodePool& operator=(const DecodePool&) = delete;
+
+  // Queues a GOP unless it is already cached, queued, being decoded or failed too often. Urgent GOPs are decoded next
+  void submit(uint32_t keyFrame, int64_t keyFramePts, uint32_t frameCount, bool urgent = false);
+
+  // Drops queued GOPs that no worker has started on yet
+  void cancelPending();
+
+  // Size GOPs are decoded at from now on, 0 keeps the video's own size. Drops the queued GOPs, GOPs being decoded at the
+  // old size are discarded once they finish
+  void setOutputSize(int width, int height);
+
+  // GOPs of this file decoded in parallel at most, one per decoder
+  [[nodiscard]] uint32_t getWorkerCount() const;
+
+  // Whether the GOP failed to decode so often that it isn't submitted anymore, e.g. because its data is corrupt
+  [[nodiscard]] bool hasFailed(uint32_t keyFrame);
+
+private:
+  struct DecodeJob {
+    uint32_t keyFrame;
+    int64_t keyFramePts;
+    uint32_t frameCount;
+  };
+
+  GopCache& cache;
+  DecodeScheduler& scheduler;
+
+  std::mutex mutex;
+  std::deque<DecodeJob> jobs;
+
+  // Decoders no task is using, a task takes one for each GOP
+  std::vector<std::unique_ptr<GopDecoder>> idleDecoders;
+  uint32_t decoderCount = 0;
+
+  // Tasks on the scheduler that haven't started yet, and whether one of them has playhead priority
+  uint32_t queuedTasks = 0;
+  bool urgentTaskQueued = false;
+
+  // Key frames that are queued or being decoded
+  std::unordered_set<uint32_t> pending;
+
+  // Failed decodes per key frame, failures aren't cached so the GOP is tried again until it gives up
+  std::unordered_map<uint32_t, uint32_t> failures;
+
+  int outputWidth = 0;
+  int outputHeight = 0;
+
+  // Has the scheduler run a task for every queued job a decoder is free for. Called with the mutex held
+  void scheduleJobs(bool urgent);
+
+  // Decodes the next queued job, if there still is one and a decoder is free
+  void runJob(bool urgentTask);
+
+  // Called with the mutex held
+  [[nodiscard]] bool hasFailedLocked(uint32_t keyFrame) const;
+};
+
+} // AVParser
+
+#endif //DECODEPOOL_H
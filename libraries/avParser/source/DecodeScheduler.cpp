@@ -0,0 +1,115 @@
+#include "DecodeScheduler.h"
+#include <algorithm>
+
+namespace AVParser {
+  // Workers of the shared scheduler at most, each decoder spreads its frame threads over the cores left to it
+  constexpr uint32_t maxSharedWorkers = 8;
+
+  DecodeScheduler::DecodeScheduler(const uint32_t workerCount)
+  {
+    for (uint32_t i = 0; i < std::max(workerCount, 1u); i++)
+    {
+      workers.emplace_back(&DecodeScheduler::worker, this);
+    }
+  }
+
+  DecodeScheduler::~DecodeScheduler()
+  {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+
+    taskAvailable.notify_all();
+
+    for (auto& worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  DecodeScheduler& DecodeScheduler::getShared()
+  {
+    static DecodeScheduler scheduler(std::clamp(std::thread::hardware_concurrency() / 2, 2u, maxSharedWorkers));
+
+    return scheduler;
+  }
+
+  void DecodeScheduler::submit(const void* owner, const DecodePriority priority, Task task)
+  {
+    {
+      std::lock_guard lock(mutex);
+      queues[static_cast<size_t>(priority)].push_back({ .owner = owner, .task = std::move(task) });
+    }
+
+    taskAvailable.notify_one();
+  }
+
+  void DecodeScheduler::cancel(const void* owner)
+  {
+    std::unique_lock lock(mutex);
+
+    const auto dropQueued = [&] {
+      for (auto& queue : queues)
+      {
+        std::erase_if(queue, [owner](const QueuedTask& queued) { return queued.owner == owner; });
+      }
+    };
+
+    dropQueued();
+
+    taskFinished.wait(lock, [&] { return !running.contains(owner); });
+
+    // A running task may have submitted a follow-up before it finished
+    dropQueued();
+  }
+
+  uint32_t DecodeScheduler::getWorkerCount() const
+  {
+    return static_cast<uint32_t>(workers.size());
+  }
+
+  void DecodeScheduler::worker()
+  {
+    std::unique_lock lock(mutex);
+
+    while (true)
+    {
+      taskAvailable.wait(lock, [this] {
+        return stopping || std::ranges::any_of(queues, [](const auto& queue) { return !queue.empty(); });
+      });
+
+      if (stopping)
+      {
+        return;
+      }
+
+      auto& queue = *std::ranges::find_if(queues, [](const auto& queue) { return !queue.empty(); });
+      QueuedTask queued = std::move(queue.front());
+      queue.pop_front();
+
+      running[queued.owner]++;
+
+      lock.unlock();
+
+      try
+      {
+        queued.task();
+      }
+      catch ([[maybe_unused]] const std::exception& e)
+      { /* Tasks report their own errors, one that throws must not take the worker down */ }
+
+      // Destroy what the task captured before its owner is told it is done
+      queued.task = nullptr;
+
+      lock.lock();
+
+      if (--running[queued.owner] == 0)
+      {
+        running.erase(queued.owner);
+      }
+
+      taskFinished.notify_all();
+    }
+  }
+} // AVParser
@@ -0,0 +1,73 @@
+#ifndef DECODESCHEDULER_H
+#define DECODESCHEDULER_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace AVParser {
+
+// Higher classes are always run first, tasks of one class in the order they were submitted
+enum class DecodePriority {
+  PLAYHEAD,  // The frame on screen is waiting for it
+  PREFETCH,  // Frames ahead of the playhead
+  THUMBNAIL  // Anything else in the background
+};
+
+// A fixed pool of worker threads shared by every open file, so opening several files doesn't oversubscribe the CPU.
+// Tasks are short units of work like decoding one GOP, a task that has more to do submits another one
+class DecodeScheduler {
+public:
+  using Task = std::function<void()>;
+
+  explicit DecodeScheduler(uint32_t workerCount);
+
+  ~DecodeScheduler();
+
+  DecodeScheduler(const DecodeScheduler&) = delete;
+  DecodeScheduler& operator=(const DecodeScheduler&) = delete;
+
+  // The process wide scheduler, started with about half the cores on first use
+  [[nodiscard]] static DecodeScheduler& getShared();
+
+  // Queues a task on behalf of owner, which has to call cancel before it is destroyed
+  void submit(const void* owner, DecodePriority priority, Task task);
+
+  // Drops the queued tasks of owner and waits for its running ones, including whatever they submit meanwhile
+  void cancel(const void* owner);
+
+  [[nodiscard]] uint32_t getWorkerCount() const;
+
+private:
+  struct QueuedTask {
+    const void* owner;
+    Task task;
+  };
+
+  static constexpr size_t priorityCount = 3;
+
+  std::mutex mutex;
+  std::condition_variable taskAvailable;
+  std::condition_variable taskFinished;
+
+  std::array<std::deque<QueuedTask>, priorityCount> queues;
+
+  // Tasks being run per owner
+  std::unordered_map<const void*, uint32_t> running;
+
+  bool stopping = false;
+
+  std::vector<std::thread> workers;
+
+  void worker();
+};
+
+} // AVParser
+
+#endif //DECODESCHEDULER_H
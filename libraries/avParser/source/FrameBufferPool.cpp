@@ -0,0 +1,50 @@
+#include "FrameBufferPool.h"
+#include <atomic>
+
+namespace AVParser {
+  FrameBuffer FrameBufferPool::acquire(const size_t size)
+  {
+    std::lock_guard lock(mutex);
+
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+      const size_t index = (cursor + i) % buffers.size();
+      auto& buffer = buffers[index];
+
+      // Nobody else can copy a buffer only the pool holds, so it can't be taken while it is reused
+      if (buffer.use_count() != 1)
+      {
+        continue;
+      }
+
+      // Make the last reader's accesses visible before the buffer is written again
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      cursor = index + 1;
+
+      // Same sized frames keep their allocation
+      buffer->resize(size);
+      return buffer;
+    }
+
+    cursor = 0;
+    return buffers.emplace_back(std::make_shared<std::vector<uint8_t>>(size));
+  }
+
+  void FrameBufferPool::trim()
+  {
+    std::lock_guard lock(mutex);
+
+    std::erase_if(buffers, [](const FrameBuffer& buffer) {
+      return buffer.use_count() == 1;
+    });
+
+    cursor = 0;
+  }
+
+  size_t FrameBufferPool::getBufferCount() const
+  {
+    std::lock_guard lock(mutex);
+    return buffers.size();
+  }
+} // AVParser
@@ -0,0 +1,37 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace AVParser {
+
+// One decoded frame, shared by the GOP cache and whoever is displaying it
+using FrameBuffer = std::shared_ptr<std::vector<uint8_t>>;
+
+// Recycles frame buffers so decoding doesn't allocate per frame. A buffer is free again once the pool holds the
+// only reference to it, so releasing a frame is just dropping the shared pointer
+class FrameBufferPool {
+public:
+  // Returns a buffer of the given size that nobody else references, allocating only if none is free
+  [[nodiscard]] FrameBuffer acquire(size_t size);
+
+  // Frees the buffers that aren't in use, e.g. when a new file is opened
+  void trim();
+
+  [[nodiscard]] size_t getBufferCount() const;
+
+private:
+  mutable std::mutex mutex;
+
+  std::vector<FrameBuffer> buffers;
+
+  // Where the search for a free buffer starts, buffers just handed out are the least likely to be free
+  size_t cursor = 0;
+};
+
+} // AVParser
+
+#endif //FRAMEBUFFERPOOL_H
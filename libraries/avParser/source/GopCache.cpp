@@ -0,0 +1,302 @@
+#include "GopCache.h"
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+namespace AVParser {
+  // GOPs already played count as this many times farther away than GOPs still ahead
+  constexpr uint64_t behindPlayheadWeight = 4;
+
+  std::atomic<size_t> GopCache::sharedByteBudget = defaultSharedByteBudget;
+  std::atomic<size_t> GopCache::sharedUsedBytes = 0;
+  std::atomic<uint32_t> GopCache::cacheCount = 0;
+
+  std::mutex GopCache::registryMutex;
+  std::vector<GopCache*> GopCache::caches;
+
+  GopCache::GopCache(const size_t byteBudget)
+    : byteBudget(byteBudget)
+  {
+    std::lock_guard lock(registryMutex);
+    caches.push_back(this);
+    ++cacheCount;
+  }
+
+  GopCache::~GopCache()
+  {
+    std::lock_guard lock(registryMutex);
+    std::erase(caches, this);
+    sharedUsedBytes -= usedBytes;
+    --cacheCount;
+  }
+
+  void GopCache::setByteBudget(const size_t byteBudget)
+  {
+    std::lock_guard lock(mutex);
+    this->byteBudget = byteBudget;
+  }
+
+  size_t GopCache::getByteBudget() const
+  {
+    std::lock_guard lock(mutex);
+    return getEffectiveBudget();
+  }
+
+  void GopCache::setSharedByteBudget(const size_t byteBudget)
+  {
+    sharedByteBudget = byteBudget;
+  }
+
+  size_t GopCache::getSharedByteBudget()
+  {
+    return sharedByteBudget;
+  }
+
+  size_t GopCache::getSharedUsedBytes()
+  {
+    return sharedUsedBytes;
+  }
+
+  void GopCache::setUsedBytes(const size_t bytes)
+  {
+    // Wraps around when shrinking, which adds up to the right total all the same
+    sharedUsedBytes += bytes - usedBytes;
+    usedBytes = bytes;
+  }
+
+  size_t GopCache::getEffectiveBudget() const
+  {
+    const size_t shared = sharedByteBudget;
+    const size_t allUsed = sharedUsedBytes;
+    const size_t othersUsed = allUsed - std::min(usedBytes, allUsed);
+
+    // Whatever the others leave over, but never less than an even share, so one file can't starve the rest
+    const size_t fairShare = shared / std::max(cacheCount.load(), 1u);
+    const size_t leftOver = shared > othersUsed ? shared - othersUsed : 0;
+
+    return std::min(byteBudget, std::max(fairShare, leftOver));
+  }
+
+  void GopCache::insert(const uint32_t keyFrame, FrameCache frames)
+  {
+    // Padding at the end of a GOP repeats the last buffer, count it once
+    size_t bytes = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+      if (i == 0 || frames[i] != frames[i - 1])
+      {
+        bytes += frames[i]->capacity();
+      }
+    }
+
+    CachedGop gop {
+      .frames = std::make_shared<const FrameCache>(std::move(frames)),
+      .bytes = bytes
+    };
+
+    {
+      std::lock_guard lock(mutex);
+
+      size_t bytes = usedBytes + gop.bytes;
+      if (const auto it = gops.find(keyFrame); it != gops.end())
+      {
+        bytes -= it->second.bytes;
+      }
+
+      setUsedBytes(bytes);
+      gops[keyFrame] = std::move(gop);
+
+      // The owner may not evict for a while (e.g. while paused), so the shared budget is held to here
+      if (sharedUsedBytes > sharedByteBudget)
+      {
+        std::ranges::copy(trim(), std::back_inserter(trimmed));
+      }
+    }
+
+    gopInserted.notify_all();
+
+    if (sharedUsedBytes > sharedByteBudget)
+    {
+      trimOthers();
+    }
+  }
+
+  std::shared_ptr<const FrameCache> GopCache::find(const uint32_t keyFrame) const
+  {
+    std::lock_guard lock(mutex);
+
+    const auto it = gops.find(keyFrame);
+    return it != gops.end() ? it->second.frames : nullptr;
+  }
+
+  std::shared_ptr<const FrameCache> GopCache::lookup(const uint32_t keyFrame)
+  {
+    std::lock_guard lock(mutex);
+
+    const auto it = gops.find(keyFrame);
+    if (it == gops.end())
+    {
+      misses++;
+      return nullptr;
+    }
+
+    hits++;
+    return it->second.frames;
+  }
+
+  std::shared_ptr<const FrameCache> GopCache::waitFor(const uint32_t keyFrame,
+                                                      const std::chrono::milliseconds timeout) const
+  {
+    std::unique_lock lock(mutex);
+
+    gopInserted.wait_for(lock, timeout, [this, keyFrame] { return gops.contains(keyFrame); });
+
+    const auto it = gops.find(keyFrame);
+    return it != gops.end() ? it->second.frames : nullptr;
+  }
+
+  bool GopCache::contains(const uint32_t keyFrame) const
+  {
+    std::lock_guard lock(mutex);
+    return gops.contains(keyFrame);
+  }
+
+  void GopCache::erase(const uint32_t keyFrame)
+  {
+    std::lock_guard lock(mutex);
+
+    if (const auto it = gops.find(keyFrame); it != gops.end())
+    {
+      setUsedBytes(usedBytes - it->second.bytes);
+      gops.erase(it);
+    }
+  }
+
+  void GopCache::clear()
+  {
+    std::lock_guard lock(mutex);
+
+    gops.clear();
+    setUsedBytes(0);
+  }
+
+  std::vector<uint32_t> GopCache::evict(const uint32_t playhead, const uint32_t playingKeyFrame,
+                                        const PlaybackDirection direction)
+  {
+    std::lock_guard lock(mutex);
+
+    this->playhead = playhead;
+    this->playingKeyFrame = playingKeyFrame;
+    this->direction = direction;
+
+    std::vector<uint32_t> evicted = std::exchange(trimmed, {});
+    std::ranges::copy(trim(), std::back_inserter(evicted));
+
+    return evicted;
+  }
+
+  std::vector<uint32_t> GopCache::trim()
+  {
+    std::vector<uint32_t> evicted;
+
+    const auto score = [&](const uint32_t keyFrame) {
+      const bool ahead = keyFrame > playhead;
+      const uint64_t distance = ahead ? keyFrame - playhead : playhead - keyFrame;
+
+      const bool behind = (direction == PlaybackDirection::FORWARD && !ahead) ||
+                          (direction == PlaybackDirection::BACKWARD && ahead);
+
+      return behind ? distance * behindPlayheadWeight : distance;
+    };
+
+    const size_t budget = getEffectiveBudget();
+
+    while (usedBytes > budget)
+    {
+      auto victim = gops.end();
+      uint64_t victimScore = 0;
+
+      for (auto it = gops.begin(); it != gops.end(); ++it)
+      {
+        if (it->first == playingKeyFrame)
+        {
+          continue;
+        }
+
+        if (const uint64_t itScore = score(it->first); victim == gops.end() || itScore > victimScore)
+        {
+          victim = it;
+          victimScore = itScore;
+        }
+      }
+
+      if (victim == gops.end())
+      {
+        break;
+      }
+
+      setUsedBytes(usedBytes - victim->second.bytes);
+      evicted.push_back(victim->first);
+      gops.erase(victim);
+      evictions++;
+    }
+
+    return evicted;
+  }
+
+  void GopCache::trimOthers() const
+  {
+    std::lock_guard registryLock(registryMutex);
+
+    for (GopCache* cache : caches)
+    {
+      if (cache == this)
+      {
+        continue;
+      }
+
+      std::lock_guard lock(cache->mutex);
+
+      if (cache->usedBytes > cache->getEffectiveBudget())
+      {
+        std::ranges::copy(cache->trim(), std::back_inserter(cache->trimmed));
+      }
+    }
+  }
+
+  std::vector<uint32_t> GopCache::getKeyFrames() const
+  {
+    std::lock_guard lock(mutex);
+
+    std::vector<uint32_t> keyFrames;
+    keyFrames.reserve(gops.size());
+
+    for (const auto& keyFrame : gops | std::views::keys)
+    {
+      keyFrames.push_back(keyFrame);
+    }
+
+    return keyFrames;
+  }
+
+  size_t GopCache::size() const
+  {
+    std::lock_guard lock(mutex);
+    return gops.size();
+  }
+
+  CacheStats GopCache::getStats() const
+  {
+    std::lock_guard lock(mutex);
+
+    return {
+      .hits = hits,
+      .misses = misses,
+      .evictions = evictions,
+      .usedBytes = usedBytes,
+      .byteBudget = getEffectiveBudget(),
+      .cachedGops = gops.size()
+    };
+  }
+} // AVParser
@@ -0,0 +1,141 @@
+#ifndef GOPCACHE_H
+#define GOPCACHE_H
+
+#include "FrameBufferPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace AVParser {
+
+// Decoded frames of one group of pictures, starting at its keyframe
+using FrameCache = std::vector<FrameBuffer>;
+
+enum class PlaybackDirection {
+  FORWARD,
+  BACKWARD,
+  NONE
+};
+
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t usedBytes = 0;
+  size_t byteBudget = 0;
+  size_t cachedGops = 0;
+};
+
+// Decoded GOPs keyed by the frame number of their keyframe, shared between the decode workers and the parser. Every
+// cache also counts towards a budget shared by all of them, so opening more files doesn't take more memory. An insert
+// that takes all caches together over it trims every cache over its budget right away, a cache's own budget is only
+// enforced once its owner evicts
+class GopCache {
+public:
+  static constexpr size_t defaultByteBudget = 2ull << 30;
+  static constexpr size_t defaultSharedByteBudget = 4ull << 30;
+
+  explicit GopCache(size_t byteBudget = defaultByteBudget);
+
+  ~GopCache();
+
+  GopCache(const GopCache&) = delete;
+  GopCache& operator=(const GopCache&) = delete;
+
+  void setByteBudget(size_t byteBudget);
+
+  // The budget the cache is held to: its own one, lowered to what the other caches leave of the shared budget. Each
+  // cache can always use an even share of the shared budget
+  [[nodiscard]] size_t getByteBudget() const;
+
+  // Memory for the decoded frames of all caches together
+  static void setSharedByteBudget(size_t byteBudget);
+
+  [[nodiscard]] static size_t getSharedByteBudget();
+
+  // Bytes used by all caches together
+  [[nodiscard]] static size_t getSharedUsedBytes();
+
+  void insert(uint32_t keyFrame, FrameCache frames);
+
+  // Returns nullptr if the GOP is not decoded yet, the returned frames stay valid after eviction
+  [[nodiscard]] std::shared_ptr<const FrameCache> find(uint32_t keyFrame) const;
+
+  // Same as find, but counts towards the hit and miss statistics
+  [[nodiscard]] std::shared_ptr<const FrameCache> lookup(uint32_t keyFrame);
+
+  // Blocks until the GOP is inserted, returns nullptr if it wasn't within the timeout. Doesn't count as a hit or miss
+  [[nodiscard]] std::shared_ptr<const FrameCache> waitFor(uint32_t keyFrame, std::chrono::milliseconds timeout) const;
+
+  [[nodiscard]] bool contains(uint32_t keyFrame) const;
+
+  void erase(uint32_t keyFrame);
+
+  void clear();
+
+  // Evicts GOPs until the cache fits getByteBudget and returns their key frames, including the ones trimmed by inserts
+  // since the last call. GOPs behind the playhead go first, then the ones farthest from it. The GOP being played is
+  // never evicted, trimming on insert goes by the playhead of the last call
+  std::vector<uint32_t> evict(uint32_t playhead, uint32_t playingKeyFrame, PlaybackDirection direction);
+
+  [[nodiscard]] std::vector<uint32_t> getKeyFrames() const;
+
+  [[nodiscard]] size_t size() const;
+
+  [[nodiscard]] CacheStats getStats() const;
+
+private:
+  struct CachedGop {
+    std::shared_ptr<const FrameCache> frames;
+    size_t bytes;
+  };
+
+  mutable std::mutex mutex;
+  mutable std::condition_variable gopInserted;
+
+  std::unordered_map<uint32_t, CachedGop> gops;
+
+  size_t byteBudget;
+  size_t usedBytes = 0;
+
+  // Where the owner last evicted from, so trimming on insert keeps the GOPs it would keep
+  uint32_t playhead = 0;
+  uint32_t playingKeyFrame = std::numeric_limits<uint32_t>::max();
+  PlaybackDirection direction = PlaybackDirection::NONE;
+
+  // Key frames trimmed on insert that the owner hasn't been told about by evict yet
+  std::vector<uint32_t> trimmed;
+
+  static std::atomic<size_t> sharedByteBudget;
+  static std::atomic<size_t> sharedUsedBytes;
+  static std::atomic<uint32_t> cacheCount;
+
+  // Every live cache, so an insert can trim the others. Never locked while holding a cache's mutex
+  static std::mutex registryMutex;
+  static std::vector<GopCache*> caches;
+
+  // Keeps sharedUsedBytes in step with usedBytes. Called with the mutex held
+  void setUsedBytes(size_t bytes);
+
+  [[nodiscard]] size_t getEffectiveBudget() const;
+
+  // Evicts GOPs from the last eviction's playhead until the cache fits getEffectiveBudget. Called with the mutex held
+  std::vector<uint32_t> trim();
+
+  // Trims every other cache over its budget
+  void trimOthers() const;
+
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+};
+
+} // AVParser
+
+#endif //GOPCACHE_H
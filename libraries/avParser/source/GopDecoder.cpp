@@ -0,0 +1,232 @@
+#include "GopDecoder.h"
+#include "MediaInput.h"
+#include <stdexcept>
+
+namespace AVParser {
+  size_t getFrameBytes(const FrameFormat frameFormat, const int width, const int height)
+  {
+    const auto pixels = static_cast<size_t>(width) * height;
+
+    if (frameFormat == FrameFormat::NV12)
+    {
+      // Chroma is subsampled 2x2, rounding up for odd sizes
+      return pixels + static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2) * 2;
+    }
+
+    return pixels * 4;
+  }
+
+  void applyDecoderParams(AVCodecContext* codecContext, const DecoderParams& params, const int threadCount)
+  {
+    codecContext->thread_count = threadCount;
+
+    switch (params.threadingMode)
+    {
+      case ThreadingMode::FRAME:
+        codecContext->thread_type = FF_THREAD_FRAME;
+        break;
+      case ThreadingMode::SLICE:
+        codecContext->thread_type = FF_THREAD_SLICE;
+        break;
+      default:
+        codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        break;
+    }
+
+    codecContext->skip_loop_filter = params.skipLoopFilter;
+    codecContext->skip_idct = params.skipIdct;
+    codecContext->skip_frame = params.skipFrame;
+  }
+
+  GopDecoder::GopDecoder(const std::string& mediaFile, const int videoStreamIndex, const DecoderParams& params,
+                         const int threadCount, FrameBufferPool& framePool)
+    : videoStreamIndex(videoStreamIndex), frameFormat(params.frameFormat), framePool(framePool)
+  {
+    if (MediaInput::open(&formatContext, mediaFile) < 0)
+    {
+      throw std::runtime_error("Failed to open video file!");
+    }
+
+    if (avformat_find_stream_info(formatContext, nullptr) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to retrieve stream info!");
+    }
+
+    // Only the video stream is needed, let the demuxer drop everything else
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+    {
+      formatContext->streams[i]->discard = static_cast<int>(i) == videoStreamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+
+    const AVCodecParameters* codecParams = formatContext->streams[videoStreamIndex]->codecpar;
+
+    const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
+    if (!codec)
+    {
+      close();
+      throw std::runtime_error("Failed to find video decoder!");
+    }
+
+    codecContext = avcodec_alloc_context3(codec);
+    if (!codecContext || avcodec_parameters_to_context(codecContext, codecParams) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to open video codec!");
+    }
+
+    applyDecoderParams(codecContext, params, threadCount);
+
+    if (avcodec_open2(codecContext, codec, nullptr) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to open video codec!");
+    }
+
+    outputWidth = codecContext->width;
+    outputHeight = codecContext->height;
+
+    swsContext = createSwsContext();
+
+    frame = av_frame_alloc();
+    packet = av_packet_alloc();
+
+    if (!swsContext || !frame || !packet)
+    {
+      close();
+      throw std::runtime_error("Failed to allocate video decoder resources!");
+    }
+  }
+
+  GopDecoder::~GopDecoder()
+  {
+    close();
+  }
+
+  void GopDecoder::setOutputSize(const int width, const int height)
+  {
+    const int newWidth = width > 0 ? width : codecContext->width;
+    const int newHeight = height > 0 ? height : codecContext->height;
+
+    if (newWidth == outputWidth && newHeight == outputHeight)
+    {
+      return;
+    }
+
+    outputWidth = newWidth;
+    outputHeight = newHeight;
+
+    sws_freeContext(swsContext);
+    swsContext = createSwsContext();
+
+    if (!swsContext)
+    {
+      throw std::runtime_error("Failed to create the scaler for the new output size!");
+    }
+  }
+
+  FrameCache GopDecoder::decode(const int64_t keyFramePts, const uint32_t frameCount)
+  {
+    FrameCache frames;
+    frames.reserve(frameCount);
+
+    if (av_seek_frame(formatContext, videoStreamIndex, keyFramePts, AVSEEK_FLAG_BACKWARD) < 0)
+    {
+      throw std::runtime_error("Seek failed");
+    }
+
+    avcodec_flush_buffers(codecContext);
+
+    while (frames.size() < frameCount && av_read_frame(formatContext, packet) >= 0)
+    {
+      if (packet->stream_index == videoStreamIndex && avcodec_send_packet(codecContext, packet) == 0)
+      {
+        receiveFrames(frames, keyFramePts, frameCount);
+      }
+
+      av_packet_unref(packet);
+    }
+
+    // Drain the frames still held by the decoder at the end of the file
+    if (frames.size() < frameCount && avcodec_send_packet(codecContext, nullptr) == 0)
+    {
+      receiveFrames(frames, keyFramePts, frameCount);
+    }
+
+    // Keep one entry per frame even if the tail of the GOP failed to decode, sharing the last buffer
+    while (!frames.empty() && frames.size() < frameCount)
+    {
+      frames.push_back(frames.back());
+    }
+
+    return frames;
+  }
+
+  void GopDecoder::receiveFrames(FrameCache& frames, const int64_t keyFramePts, const uint32_t frameCount)
+  {
+    while (frames.size() < frameCount && avcodec_receive_frame(codecContext, frame) == 0)
+    {
+      // Leading frames of an open GOP are presented before the keyframe and belong to the previous GOP
+      if (frame->best_effort_timestamp != AV_NOPTS_VALUE && frame->best_effort_timestamp < keyFramePts)
+      {
+        continue;
+      }
+
+      convertFrame(frames);
+    }
+  }
+
+  void GopDecoder::convertFrame(FrameCache& frames) const
+  {
+    if (!frame->data[0])
+    {
+      throw std::runtime_error("Invalid frame data in convertFrame");
+    }
+
+    const int width = outputWidth;
+    const int height = outputHeight;
+
+    // sws_scale writes straight into the pooled buffer that the cache and the player share
+    const auto& buffer = frames.emplace_back(framePool.acquire(getFrameBytes(frameFormat, width, height)));
+    uint8_t* data = buffer->data();
+
+    if (frameFormat == FrameFormat::NV12)
+    {
+      uint8_t* dst[2] = { data, data + static_cast<size_t>(width) * height };
+      const int dstStride[2] = { width, (width + 1) / 2 * 2 };
+
+      sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+      return;
+    }
+
+    uint8_t* dst[1] = { data };
+    const int dstStride[1] = { width * 4 };
+
+    sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+  }
+
+  SwsContext* GopDecoder::createSwsContext() const
+  {
+    // NV12 output is a plain repack for 8 bit 4:2:0 sources, only RGBA needs the colour conversion
+    const AVPixelFormat outputFormat = frameFormat == FrameFormat::NV12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_RGBA;
+
+    // Area averaging when shrinking to the viewport, bilinear is enough at the video's own size
+    const int flags = outputWidth < codecContext->width ? SWS_AREA : SWS_BILINEAR;
+
+    return sws_getContext(codecContext->width, codecContext->height, codecContext->pix_fmt,
+                          outputWidth, outputHeight, outputFormat, flags, nullptr, nullptr, nullptr);
+  }
+
+  void GopDecoder::close()
+  {
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+
+    sws_freeContext(swsContext);
+    swsContext = nullptr;
+
+    avcodec_free_context(&codecContext);
+
+    MediaInput::close(&formatContext);
+  }
+} // AVParser
@@ -0,0 +1,100 @@
+#ifndef GOPDECODER_H
+#define GOPDECODER_H
+
+#include "GopCache.h"
+#include "ReadPrefetcher.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+#include <string>
+
+namespace AVParser {
+
+enum class FrameFormat {
+  RGBA, // 4 bytes per pixel, converted on the CPU
+  NV12  // Full size Y plane followed by an interleaved half size UV plane, 1.5 bytes per pixel
+};
+
+enum class ColorMatrix {
+  BT601,
+  BT709,
+  BT2020
+};
+
+[[nodiscard]] size_t getFrameBytes(FrameFormat frameFormat, int width, int height);
+
+enum class ThreadingMode {
+  AUTO,  // Let FFmpeg pick what the codec supports
+  FRAME, // Decode several frames at once, more throughput but more latency
+  SLICE  // Split each frame into slices, no added latency but only for codecs/files with slices
+};
+
+struct DecoderParams {
+  FrameFormat frameFormat = FrameFormat::RGBA;
+  uint32_t decodeWorkers = 0; // GOPs decoded in parallel, 0 picks from the core count
+  int threadsPerDecoder = 0;  // 0 splits the cores between the workers
+  ThreadingMode threadingMode = ThreadingMode::AUTO;
+
+  // Quality shortcuts, e.g. AVDISCARD_NONREF or AVDISCARD_ALL for faster scrubbing
+  AVDiscard skipLoopFilter = AVDISCARD_DEFAULT;
+  AVDiscard skipIdct = AVDISCARD_DEFAULT;
+  AVDiscard skipFrame = AVDISCARD_DEFAULT;
+
+  size_t videoCacheBytes = GopCache::defaultByteBudget; // Memory for decoded frames, the playing GOP may exceed it
+
+  // Reads the GOPs queued for decoding into the page cache ahead of the decoders, for slow disks and network storage
+  ReadBackend readBackend = ReadBackend::PREAD;
+  uint32_t readQueueDepth = 16; // Reads in flight with io_uring
+};
+
+// Applies the threading and skip options of params to a codec context before it is opened
+void applyDecoderParams(AVCodecContext* codecContext, const DecoderParams& params, int threadCount);
+
+// Owns a demuxer and video decoder of its own so several GOPs of one file can be decoded in parallel
+class GopDecoder {
+public:
+  GopDecoder(const std::string& mediaFile, int videoStreamIndex, const DecoderParams& params, int threadCount,
+             FrameBufferPool& framePool);
+
+  ~GopDecoder();
+
+  GopDecoder(const GopDecoder&) = delete;
+  GopDecoder& operator=(const GopDecoder&) = delete;
+
+  // Size the frames are converted to, 0 keeps the video's own size
+  void setOutputSize(int width, int height);
+
+  // Decodes frameCount frames in presentation order, starting at the keyframe with the given PTS
+  [[nodiscard]] FrameCache decode(int64_t keyFramePts, uint32_t frameCount);
+
+private:
+  AVFormatContext* formatContext = nullptr;
+  AVCodecContext* codecContext = nullptr;
+  SwsContext* swsContext = nullptr;
+  AVFrame* frame = nullptr;
+  AVPacket* packet = nullptr;
+
+  int videoStreamIndex;
+
+  FrameFormat frameFormat;
+
+  int outputWidth = 0;
+  int outputHeight = 0;
+
+  FrameBufferPool& framePool;
+
+  [[nodiscard]] SwsContext* createSwsContext() const;
+
+  void receiveFrames(FrameCache& frames, int64_t keyFramePts, uint32_t frameCount);
+
+  void convertFrame(FrameCache& frames) const;
+
+  void close();
+};
+
+} // AVParser
+
+#endif //GOPDECODER_H
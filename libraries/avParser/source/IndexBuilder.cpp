@@ -0,0 +1,132 @@
+#include "IndexBuilder.h"
+#include "MediaInput.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+namespace AVParser {
+  // How often a partial index is published at most
+  constexpr auto publishInterval = std::chrono::milliseconds(500);
+
+  // Each partial index copies and sorts every packet read so far, so publishing gets slower as the file is read. The
+  // interval grows with it, keeping publishing to about a tenth of the builder's time instead of letting the whole
+  // build go quadratic on a long file
+  constexpr int publishCostFactor = 10;
+
+  // A partial index is published at every keyframe until it has this many frames, so the first frames can be shown
+  constexpr uint32_t firstPublishFrames = 2;
+
+  IndexBuilder::IndexBuilder(const std::string& mediaFile, const int videoStreamIndex, const int audioStreamIndex,
+                             PublishCallback publish)
+    : mediaFile(mediaFile), videoStreamIndex(videoStreamIndex), audioStreamIndex(audioStreamIndex),
+      publish(std::move(publish))
+  {
+    worker = std::thread(&IndexBuilder::buildIndex, this);
+  }
+
+  IndexBuilder::~IndexBuilder()
+  {
+    stopping = true;
+
+    worker.join();
+  }
+
+  void IndexBuilder::buildIndex()
+  {
+    AVFormatContext* formatContext = nullptr;
+    std::vector<PacketEntry> packets;
+    AVRational videoTimeBase{ 0, 1 };
+    AVRational audioTimeBase{ 0, 1 };
+
+    if (MediaInput::open(&formatContext, mediaFile) >= 0 &&
+        avformat_find_stream_info(formatContext, nullptr) >= 0 &&
+        std::max(videoStreamIndex, audioStreamIndex) < static_cast<int>(formatContext->nb_streams))
+    {
+      videoTimeBase = formatContext->streams[videoStreamIndex]->time_base;
+      audioTimeBase = formatContext->streams[audioStreamIndex]->time_base;
+
+      AVPacket* packet = av_packet_alloc();
+      int64_t lastKeyFramePts = AV_NOPTS_VALUE;
+      uint32_t publishedFrames = 0;
+      auto lastPublish = std::chrono::steady_clock::now();
+      std::chrono::steady_clock::duration publishDelay = publishInterval;
+
+      // Same single demux pass as PacketIndex::build. A read error ends the index early, the file is then played as
+      // far as it could be read
+      while (packet && !stopping && av_read_frame(formatContext, packet) >= 0)
+      {
+        if (packet->stream_index == videoStreamIndex || packet->stream_index == audioStreamIndex)
+        {
+          const PacketEntry& entry = packets.emplace_back(PacketEntry{
+            .pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts,
+            .dts = packet->dts,
+            .pos = packet->pos,
+            .size = packet->size,
+            .streamIndex = packet->stream_index,
+            .flags = packet->flags
+          });
+
+          if (entry.streamIndex == videoStreamIndex && entry.flags & AV_PKT_FLAG_KEY && entry.pts != AV_NOPTS_VALUE)
+          {
+            // Frames of the previous GOP may still follow its keyframe in decode order, but not this one
+            const int64_t cutPts = lastKeyFramePts;
+            lastKeyFramePts = entry.pts;
+
+            const auto now = std::chrono::steady_clock::now();
+            const bool due = publishedFrames < firstPublishFrames || now - lastPublish >= publishDelay;
+
+            if (cutPts != AV_NOPTS_VALUE && due)
+            {
+              publishPartial(packets, cutPts, videoTimeBase, audioTimeBase, publishedFrames);
+
+              lastPublish = std::chrono::steady_clock::now();
+              publishDelay = std::max<std::chrono::steady_clock::duration>(publishInterval,
+                                                                           (lastPublish - now) * publishCostFactor);
+            }
+          }
+        }
+        av_packet_unref(packet);
+      }
+
+      av_packet_free(&packet);
+    }
+
+    MediaInput::close(&formatContext);
+
+    if (stopping)
+    {
+      return;
+    }
+
+    PacketIndex index;
+    index.assign(std::move(packets), videoStreamIndex, audioStreamIndex, videoTimeBase, audioTimeBase);
+
+    publish(std::move(index), true);
+  }
+
+  void IndexBuilder::publishPartial(const std::vector<PacketEntry>& packets, const int64_t cutPts,
+                                    const AVRational videoTimeBase, const AVRational audioTimeBase,
+                                    uint32_t& publishedFrames) const
+  {
+    // The audio is cut at the same time, so the audio of every GOP in the index is complete as well
+    const int64_t audioCutPts = av_rescale_q(cutPts, videoTimeBase, audioTimeBase);
+
+    std::vector<PacketEntry> entries;
+    entries.reserve(packets.size());
+
+    std::ranges::copy_if(packets, std::back_inserter(entries), [&](const PacketEntry& entry) {
+      return entry.pts != AV_NOPTS_VALUE && entry.pts < (entry.streamIndex == videoStreamIndex ? cutPts : audioCutPts);
+    });
+
+    PacketIndex index;
+    index.assign(std::move(entries), videoStreamIndex, audioStreamIndex, videoTimeBase, audioTimeBase);
+
+    if (index.getVideoFrameCount() <= publishedFrames)
+    {
+      return;
+    }
+
+    publishedFrames = index.getVideoFrameCount();
+    publish(std::move(index), false);
+  }
+} // AVParser
@@ -0,0 +1,46 @@
+#ifndef INDEXBUILDER_H
+#define INDEXBUILDER_H
+
+#include "PacketIndex.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace AVParser {
+
+// Builds the packet index of a file on a thread of its own, with a demuxer of its own, and publishes what it has read
+// so far every now and then. A partial index stops at the keyframe before the last one read, so every GOP in it is
+// complete and its frame numbers stay the same as the index grows
+class IndexBuilder {
+public:
+  // Called on the builder's thread, complete is set on the last index which covers the whole file
+  using PublishCallback = std::function<void(PacketIndex index, bool complete)>;
+
+  IndexBuilder(const std::string& mediaFile, int videoStreamIndex, int audioStreamIndex, PublishCallback publish);
+
+  ~IndexBuilder();
+
+  IndexBuilder(const IndexBuilder&) = delete;
+  IndexBuilder& operator=(const IndexBuilder&) = delete;
+
+private:
+  std::string mediaFile;
+  int videoStreamIndex;
+  int audioStreamIndex;
+
+  PublishCallback publish;
+
+  std::atomic<bool> stopping = false;
+  std::thread worker;
+
+  void buildIndex();
+
+  // Publishes the packets presented before cutPts
+  void publishPartial(const std::vector<PacketEntry>& packets, int64_t cutPts, AVRational videoTimeBase,
+                      AVRational audioTimeBase, uint32_t& publishedFrames) const;
+};
+
+} // AVParser
+
+#endif //INDEXBUILDER_H
@@ -0,0 +1,92 @@
+#include "IndexCache.h"
+#include <algorithm>
+#include <mutex>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <cstdio>
+
+namespace AVParser::IndexCache {
+  // Bytes hashed from each end of the file, enough to catch edits without reading the whole file
+  constexpr size_t contentSampleSize = 1 << 20;
+
+  MediaFileKey getMediaFileKey(const std::string& mediaFile)
+  {
+    const auto path = std::filesystem::absolute(mediaFile).lexically_normal();
+    const std::string pathString = path.string();
+
+    MediaFileKey key {
+      .pathHash = hashBytes(pathString.data(), pathString.size()),
+      .fileSize = std::filesystem::file_size(path),
+      .modifiedTime = std::filesystem::last_write_time(path).time_since_epoch().count()
+    };
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+      throw std::runtime_error("Failed to open media file for hashing!");
+    }
+
+    std::vector<char> sample(std::min<uint64_t>(contentSampleSize, key.fileSize));
+
+    file.read(sample.data(), static_cast<std::streamsize>(sample.size()));
+    key.contentHash = hashBytes(sample.data(), sample.size(), hashBytes(&key.fileSize, sizeof(key.fileSize)));
+
+    if (key.fileSize > sample.size())
+    {
+      file.seekg(static_cast<std::streamoff>(key.fileSize - sample.size()));
+      file.read(sample.data(), static_cast<std::streamsize>(sample.size()));
+      key.contentHash = hashBytes(sample.data(), sample.size(), key.contentHash);
+    }
+
+    return key;
+  }
+
+  std::filesystem::path getCacheDirectory()
+  {
+    return std::filesystem::temp_directory_path() / "medos" / "cache";
+  }
+
+  std::filesystem::path getCachePath(const MediaFileKey& key, const char* extension)
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key.pathHash));
+
+    return getCacheDirectory() / (std::string(name) + extension);
+  }
+
+  std::filesystem::path getTempPath(const std::filesystem::path& cacheFile)
+  {
+    static std::mutex randomMutex;
+    static std::mt19937_64 random{ std::random_device{}() };
+
+    unsigned long long suffix;
+    {
+      std::lock_guard lock(randomMutex);
+      suffix = random();
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), ".%016llx.tmp", suffix);
+
+    auto tempFile = cacheFile;
+    tempFile += name;
+
+    return tempFile;
+  }
+
+  uint64_t hashBytes(const void* data, const size_t size, uint64_t seed)
+  {
+    // FNV-1a
+    const auto* bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < size; i++)
+    {
+      seed ^= bytes[i];
+      seed *= 1099511628211ull;
+    }
+
+    return seed;
+  }
+} // AVParser::IndexCache
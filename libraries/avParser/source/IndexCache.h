@@ -0,0 +1,35 @@
+#ifndef INDEXCACHE_H
+#define INDEXCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace AVParser::IndexCache {
+
+// Identifies one version of a media file on disk
+struct MediaFileKey {
+  uint64_t pathHash = 0;
+  uint64_t fileSize = 0;
+  int64_t modifiedTime = 0;
+  uint64_t contentHash = 0;
+
+  bool operator==(const MediaFileKey&) const = default;
+};
+
+[[nodiscard]] MediaFileKey getMediaFileKey(const std::string& mediaFile);
+
+[[nodiscard]] std::filesystem::path getCacheDirectory();
+
+// Location of a cached file for the media file, e.g. "<cache>/<path hash>.idx"
+[[nodiscard]] std::filesystem::path getCachePath(const MediaFileKey& key, const char* extension);
+
+// Unique name next to a cache file to write it to before it is renamed into place, so parsers or processes saving the
+// same file at once don't write into each other's temp file
+[[nodiscard]] std::filesystem::path getTempPath(const std::filesystem::path& cacheFile);
+
+[[nodiscard]] uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+} // AVParser::IndexCache
+
+#endif //INDEXCACHE_H
@@ -0,0 +1,174 @@
+#include "KeyFrameDecoder.h"
+#include "MediaInput.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace AVParser {
+  std::pair<int, int> fitFrameSize(const int width, const int height, const int maxWidth, const int maxHeight)
+  {
+    if (width <= 0 || height <= 0)
+    {
+      return { 0, 0 };
+    }
+
+    const double scale = std::min({ 1.0, static_cast<double>(maxWidth) / width, static_cast<double>(maxHeight) / height });
+
+    return {
+      std::max(static_cast<int>(width * scale), 1),
+      std::max(static_cast<int>(height * scale), 1)
+    };
+  }
+
+  KeyFrameDecoder::KeyFrameDecoder(const std::string& mediaFile, const int videoStreamIndex,
+                                   const FrameFormat frameFormat, const int maxWidth, const int maxHeight)
+    : videoStreamIndex(videoStreamIndex), frameFormat(frameFormat)
+  {
+    if (MediaInput::open(&formatContext, mediaFile) < 0)
+    {
+      throw std::runtime_error("Failed to open video file!");
+    }
+
+    if (avformat_find_stream_info(formatContext, nullptr) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to retrieve stream info!");
+    }
+
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+    {
+      formatContext->streams[i]->discard = static_cast<int>(i) == videoStreamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+
+    const AVCodecParameters* codecParams = formatContext->streams[videoStreamIndex]->codecpar;
+
+    const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
+    if (!codec)
+    {
+      close();
+      throw std::runtime_error("Failed to find video decoder!");
+    }
+
+    codecContext = avcodec_alloc_context3(codec);
+    if (!codecContext || avcodec_parameters_to_context(codecContext, codecParams) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to open video codec!");
+    }
+
+    // Only keyframes are decoded, slice threading doesn't hold frames back like frame threading does
+    applyDecoderParams(codecContext, {
+      .threadingMode = ThreadingMode::SLICE,
+      .skipLoopFilter = AVDISCARD_ALL,
+      .skipFrame = AVDISCARD_NONKEY
+    }, 0);
+
+    if (avcodec_open2(codecContext, codec, nullptr) < 0)
+    {
+      close();
+      throw std::runtime_error("Failed to open video codec!");
+    }
+
+    std::tie(width, height) = fitFrameSize(codecContext->width, codecContext->height, maxWidth, maxHeight);
+
+    const AVPixelFormat outputFormat = frameFormat == FrameFormat::NV12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_RGBA;
+
+    // Area averaging keeps small outputs from aliasing, sws_scale runs it with SIMD
+    swsContext = sws_getContext(codecContext->width, codecContext->height, codecContext->pix_fmt,
+                                width, height, outputFormat, SWS_AREA, nullptr, nullptr, nullptr);
+
+    frame = av_frame_alloc();
+    packet = av_packet_alloc();
+
+    if (!swsContext || !frame || !packet)
+    {
+      close();
+      throw std::runtime_error("Failed to allocate key frame decoder resources!");
+    }
+  }
+
+  KeyFrameDecoder::~KeyFrameDecoder()
+  {
+    close();
+  }
+
+  FrameBuffer KeyFrameDecoder::decode(const int64_t keyFramePts)
+  {
+    auto buffer = std::make_shared<std::vector<uint8_t>>(getFrameBytes(frameFormat, width, height));
+
+    return decodeInto(keyFramePts, buffer->data()) ? buffer : nullptr;
+  }
+
+  bool KeyFrameDecoder::decodeInto(const int64_t keyFramePts, uint8_t* data)
+  {
+    if (av_seek_frame(formatContext, videoStreamIndex, keyFramePts, AVSEEK_FLAG_BACKWARD) < 0)
+    {
+      throw std::runtime_error("Seek failed");
+    }
+
+    avcodec_flush_buffers(codecContext);
+
+    while (av_read_frame(formatContext, packet) >= 0)
+    {
+      const bool sent = packet->stream_index == videoStreamIndex && avcodec_send_packet(codecContext, packet) == 0;
+      av_packet_unref(packet);
+
+      if (sent && receiveFrame(data))
+      {
+        return true;
+      }
+    }
+
+    // The keyframe may still be held by the decoder at the end of the file
+    return avcodec_send_packet(codecContext, nullptr) == 0 && receiveFrame(data);
+  }
+
+  int KeyFrameDecoder::getWidth() const
+  {
+    return width;
+  }
+
+  int KeyFrameDecoder::getHeight() const
+  {
+    return height;
+  }
+
+  bool KeyFrameDecoder::receiveFrame(uint8_t* data)
+  {
+    if (avcodec_receive_frame(codecContext, frame) != 0)
+    {
+      return false;
+    }
+
+    if (frameFormat == FrameFormat::NV12)
+    {
+      uint8_t* dst[2] = { data, data + static_cast<size_t>(width) * height };
+      const int dstStride[2] = { width, (width + 1) / 2 * 2 };
+
+      sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+    }
+    else
+    {
+      uint8_t* dst[1] = { data };
+      const int dstStride[1] = { width * 4 };
+
+      sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+    }
+
+    av_frame_unref(frame);
+
+    return true;
+  }
+
+  void KeyFrameDecoder::close()
+  {
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+
+    sws_freeContext(swsContext);
+    swsContext = nullptr;
+
+    avcodec_free_context(&codecContext);
+
+    MediaInput::close(&formatContext);
+  }
+} // AVParser
@@ -0,0 +1,56 @@
+#ifndef KEYFRAMEDECODER_H
+#define KEYFRAMEDECODER_H
+
+#include "GopDecoder.h"
+#include <utility>
+
+namespace AVParser {
+
+// Largest size with the aspect ratio of width x height that fits in maxWidth x maxHeight, never upscaled
+[[nodiscard]] std::pair<int, int> fitFrameSize(int width, int height, int maxWidth, int maxHeight);
+
+// Owns a demuxer and a decoder that only decodes keyframes, scaled down to fit a maximum size. Used for previews and
+// thumbnails, where decoding whole GOPs at full size would be wasted
+class KeyFrameDecoder {
+public:
+  KeyFrameDecoder(const std::string& mediaFile, int videoStreamIndex, FrameFormat frameFormat, int maxWidth,
+                  int maxHeight);
+
+  ~KeyFrameDecoder();
+
+  KeyFrameDecoder(const KeyFrameDecoder&) = delete;
+  KeyFrameDecoder& operator=(const KeyFrameDecoder&) = delete;
+
+  // Decodes the keyframe with the given PTS into a new buffer
+  [[nodiscard]] FrameBuffer decode(int64_t keyFramePts);
+
+  // Decodes the keyframe with the given PTS into data, which must hold getFrameBytes of the output size. Returns false
+  // if no frame could be decoded
+  bool decodeInto(int64_t keyFramePts, uint8_t* data);
+
+  [[nodiscard]] int getWidth() const;
+
+  [[nodiscard]] int getHeight() const;
+
+private:
+  AVFormatContext* formatContext = nullptr;
+  AVCodecContext* codecContext = nullptr;
+  SwsContext* swsContext = nullptr;
+  AVFrame* frame = nullptr;
+  AVPacket* packet = nullptr;
+
+  int videoStreamIndex;
+
+  FrameFormat frameFormat;
+
+  int width = 0;
+  int height = 0;
+
+  bool receiveFrame(uint8_t* data);
+
+  void close();
+};
+
+} // AVParser
+
+#endif //KEYFRAMEDECODER_H
@@ -0,0 +1,279 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AVParser {
+#ifdef _WIN32
+  MappedFile::MappedFile(const std::string& path)
+  {
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+      fileHandle = nullptr;
+      throw std::runtime_error("Failed to open file for mapping!");
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+      unmap();
+      throw std::runtime_error("Failed to get size of mapped file!");
+    }
+
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mappedSize == 0)
+    {
+      return;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+    {
+      unmap();
+      throw std::runtime_error("Failed to create file mapping!");
+    }
+
+    mappedData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!mappedData)
+    {
+      unmap();
+      throw std::runtime_error("Failed to map file!");
+    }
+  }
+
+  void MappedFile::advise(const AccessPattern pattern)
+  {
+    // Mapped views have no read-ahead hints, only the pattern is remembered
+    accessPattern = pattern;
+  }
+
+  void MappedFile::prefetch(size_t, size_t) const {}
+
+  size_t MappedFile::getFileSize() const
+  {
+    // A file with a mapped view can't be truncated on Windows, only grow
+    LARGE_INTEGER fileSize;
+    return GetFileSizeEx(fileHandle, &fileSize) ? static_cast<size_t>(fileSize.QuadPart) : mappedSize;
+  }
+
+  int64_t MappedFile::read(const size_t offset, uint8_t* buffer, const size_t size) const
+  {
+    if (offset >= mappedSize)
+    {
+      return 0;
+    }
+
+    const size_t count = std::min(size, mappedSize - offset);
+    std::memcpy(buffer, mappedData + offset, count);
+
+    return static_cast<int64_t>(count);
+  }
+
+  void MappedFile::unmap()
+  {
+    if (mappedData)
+    {
+      UnmapViewOfFile(mappedData);
+      mappedData = nullptr;
+    }
+
+    if (mappingHandle)
+    {
+      CloseHandle(mappingHandle);
+      mappingHandle = nullptr;
+    }
+
+    if (fileHandle)
+    {
+      CloseHandle(fileHandle);
+      fileHandle = nullptr;
+    }
+  }
+#else
+  // How long reads go without checking whether the file was truncated
+  constexpr auto sizeCheckInterval = std::chrono::milliseconds(100);
+
+  MappedFile::MappedFile(const std::string& path)
+  {
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+      throw std::runtime_error("Failed to open file for mapping!");
+    }
+
+    struct stat fileStat{};
+    if (fstat(fileDescriptor, &fileStat) < 0)
+    {
+      unmap();
+      throw std::runtime_error("Failed to get size of mapped file!");
+    }
+
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+    knownFileSize = mappedSize;
+    sizeCheckTime = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    if (mappedSize == 0)
+    {
+      return;
+    }
+
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+      unmap();
+      throw std::runtime_error("Failed to map file!");
+    }
+
+    mappedData = static_cast<const uint8_t*>(mapping);
+  }
+
+  void MappedFile::advise(const AccessPattern pattern)
+  {
+    accessPattern = pattern;
+
+    if (!mappedData)
+    {
+      return;
+    }
+
+    int advice = MADV_NORMAL;
+    if (pattern == AccessPattern::SEQUENTIAL)
+    {
+      advice = MADV_SEQUENTIAL;
+    }
+    else if (pattern == AccessPattern::RANDOM)
+    {
+      advice = MADV_RANDOM;
+    }
+
+    // Only hints, a failure just leaves the OS's default read-ahead
+    madvise(const_cast<uint8_t*>(mappedData), mappedSize, advice);
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    // Also for the page cache of the file itself, which other processes may read it through
+    int fileAdvice = POSIX_FADV_NORMAL;
+    if (pattern == AccessPattern::SEQUENTIAL)
+    {
+      fileAdvice = POSIX_FADV_SEQUENTIAL;
+    }
+    else if (pattern == AccessPattern::RANDOM)
+    {
+      fileAdvice = POSIX_FADV_RANDOM;
+    }
+
+    posix_fadvise(fileDescriptor, 0, 0, fileAdvice);
+#endif
+  }
+
+  void MappedFile::prefetch(const size_t offset, const size_t size) const
+  {
+    if (offset >= mappedSize || size == 0)
+    {
+      return;
+    }
+
+    // madvise needs a page aligned start
+    static const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = offset / pageSize * pageSize;
+    const size_t end = std::min(offset + size, mappedSize);
+
+    madvise(const_cast<uint8_t*>(mappedData) + start, end - start, MADV_WILLNEED);
+  }
+
+  size_t MappedFile::getFileSize() const
+  {
+    struct stat fileStat{};
+    const size_t fileSize = fstat(fileDescriptor, &fileStat) == 0 ? static_cast<size_t>(fileStat.st_size) : 0;
+
+    knownFileSize = fileSize;
+    sizeCheckTime = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    return fileSize;
+  }
+
+  int64_t MappedFile::read(const size_t offset, uint8_t* buffer, const size_t size) const
+  {
+    // Reads stay plain memory copies, the size is only asked for now and then instead of on every read
+    size_t fileSize = knownFileSize;
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    if (offset + size >= fileSize || now - std::chrono::steady_clock::duration(sizeCheckTime) >= sizeCheckInterval)
+    {
+      fileSize = getFileSize();
+    }
+
+    if (offset >= fileSize)
+    {
+      return 0;
+    }
+
+    const size_t count = std::min(size, fileSize - offset);
+
+    if (fileSize == mappedSize)
+    {
+      std::memcpy(buffer, mappedData + offset, count);
+      return static_cast<int64_t>(count);
+    }
+
+    // The file changed since it was mapped, pread just comes up short where the mapping would fault
+    ssize_t result;
+    do
+    {
+      result = pread(fileDescriptor, buffer, count, static_cast<off_t>(offset));
+    } while (result < 0 && errno == EINTR);
+
+    return result;
+  }
+
+  void MappedFile::unmap()
+  {
+    if (mappedData)
+    {
+      munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+      mappedData = nullptr;
+    }
+
+    if (fileDescriptor >= 0)
+    {
+      close(fileDescriptor);
+      fileDescriptor = -1;
+    }
+  }
+#endif
+
+  MappedFile::~MappedFile()
+  {
+    unmap();
+  }
+
+  const uint8_t* MappedFile::data() const
+  {
+    return mappedData;
+  }
+
+  size_t MappedFile::size() const
+  {
+    return mappedSize;
+  }
+
+  AccessPattern MappedFile::getAccessPattern() const
+  {
+    return accessPattern;
+  }
+} // AVParser
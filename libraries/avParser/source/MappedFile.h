@@ -0,0 +1,74 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace AVParser {
+
+// How a mapping is about to be read, so the OS can read ahead or not
+enum class AccessPattern {
+  NORMAL,
+  SEQUENTIAL,
+  RANDOM
+};
+
+// Read-only memory mapping of a whole file. The mapping covers the file as it was when it was opened, read copies
+// through it only while the file still has that size
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] const uint8_t* data() const;
+
+  // Size of the file when it was mapped
+  [[nodiscard]] size_t size() const;
+
+  // Size of the file now, it may have been truncated or still be written to since it was mapped. Asks the OS every
+  // time, e.g. on a seek
+  [[nodiscard]] size_t getFileSize() const;
+
+  // Copies up to size bytes at offset into buffer, returns how many were copied, 0 at the end of the file and -1 on an
+  // error. The size is checked again every so often and on reads that reach the end of the file, a file whose size
+  // changed is read with pread instead of the mapping from then on, touching mapped pages past the end of a truncated
+  // file would crash with SIGBUS
+  [[nodiscard]] int64_t read(size_t offset, uint8_t* buffer, size_t size) const;
+
+  // Hints how the whole file is read from now on, ignored on Windows
+  void advise(AccessPattern pattern);
+
+  [[nodiscard]] AccessPattern getAccessPattern() const;
+
+  // Starts reading the range into memory in the background, ignored on Windows
+  void prefetch(size_t offset, size_t size) const;
+
+private:
+  const uint8_t* mappedData = nullptr;
+  size_t mappedSize = 0;
+
+  std::atomic<AccessPattern> accessPattern = AccessPattern::NORMAL;
+
+  // Size of the file as of the last check, and when that was in steady clock ticks
+  mutable std::atomic<size_t> knownFileSize = 0;
+  mutable std::atomic<int64_t> sizeCheckTime = 0;
+
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#else
+  int fileDescriptor = -1;
+#endif
+
+  void unmap();
+};
+
+} // AVParser
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,208 @@
+#include "MediaInput.h"
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace AVParser::MediaInput {
+  // Bytes FFmpeg copies out of the mapping at a time
+  constexpr int ioBufferSize = 64 * 1024;
+
+  namespace {
+    // Position of one demuxer in the shared mapping
+    struct MappedReader {
+      std::shared_ptr<MappedFile> file;
+      int64_t position = 0;
+    };
+
+    // Every open file by its canonical path, a mapping is released once its last reader closes
+    std::mutex mappingsMutex;
+    std::map<std::string, std::weak_ptr<MappedFile>> mappings;
+
+    std::string getMappingKey(const std::string& mediaFile)
+    {
+      std::error_code error;
+      const auto path = std::filesystem::weakly_canonical(mediaFile, error);
+
+      return error ? mediaFile : path.string();
+    }
+
+    std::shared_ptr<MappedFile> shareMapping(const std::string& mediaFile)
+    {
+      const std::string key = getMappingKey(mediaFile);
+
+      std::lock_guard lock(mappingsMutex);
+
+      std::erase_if(mappings, [](const auto& entry) { return entry.second.expired(); });
+
+      if (const auto it = mappings.find(key); it != mappings.end())
+      {
+        return it->second.lock();
+      }
+
+      auto mapping = std::make_shared<MappedFile>(key);
+      mappings[key] = mapping;
+
+      return mapping;
+    }
+
+    int readPacket(void* opaque, uint8_t* buffer, const int size)
+    {
+      auto* reader = static_cast<MappedReader*>(opaque);
+
+      // Without read-ahead every page of the read would fault on its own, fetch them in one go instead
+      if (reader->file->getAccessPattern() == AccessPattern::RANDOM)
+      {
+        reader->file->prefetch(static_cast<size_t>(reader->position), static_cast<size_t>(size));
+      }
+
+      // A file truncated while it is played ends early like it would with FFmpeg's own file protocol
+      const int64_t count = reader->file->read(static_cast<size_t>(reader->position), buffer,
+                                               static_cast<size_t>(size));
+      if (count < 0)
+      {
+        return AVERROR(EIO);
+      }
+
+      if (count == 0)
+      {
+        return AVERROR_EOF;
+      }
+
+      reader->position += count;
+
+      return static_cast<int>(count);
+    }
+
+    int64_t seekPacket(void* opaque, const int64_t offset, const int whence)
+    {
+      auto* reader = static_cast<MappedReader*>(opaque);
+      const auto fileSize = static_cast<int64_t>(reader->file->getFileSize());
+
+      int64_t position;
+      switch (whence & ~AVSEEK_FORCE)
+      {
+        case AVSEEK_SIZE:
+          return fileSize;
+        case SEEK_SET:
+          position = offset;
+          break;
+        case SEEK_CUR:
+          position = reader->position + offset;
+          break;
+        case SEEK_END:
+          position = fileSize + offset;
+          break;
+        default:
+          return AVERROR(EINVAL);
+      }
+
+      if (position < 0)
+      {
+        return AVERROR(EINVAL);
+      }
+
+      // Seeking is free, nothing is read until the demuxer asks for it
+      reader->position = position;
+
+      return position;
+    }
+
+    void freeIoContext(AVIOContext*& ioContext)
+    {
+      delete static_cast<MappedReader*>(ioContext->opaque);
+
+      // FFmpeg may have replaced the buffer it was given
+      av_freep(&ioContext->buffer);
+      avio_context_free(&ioContext);
+    }
+  }
+
+  int open(AVFormatContext** formatContext, const std::string& mediaFile)
+  {
+    std::shared_ptr<MappedFile> mapping;
+    try
+    {
+      mapping = shareMapping(mediaFile);
+    }
+    catch (const std::exception&) {}
+
+    // Empty files aren't mapped, FFmpeg reports the error for those
+    if (!mapping || mapping->size() == 0)
+    {
+      return avformat_open_input(formatContext, mediaFile.c_str(), nullptr, nullptr);
+    }
+
+    auto* buffer = static_cast<uint8_t*>(av_malloc(ioBufferSize));
+    if (!buffer)
+    {
+      return AVERROR(ENOMEM);
+    }
+
+    auto* reader = new MappedReader{ .file = std::move(mapping) };
+
+    AVIOContext* ioContext = avio_alloc_context(buffer, ioBufferSize, 0, reader, readPacket, nullptr, seekPacket);
+    if (!ioContext)
+    {
+      delete reader;
+      av_free(buffer);
+      return AVERROR(ENOMEM);
+    }
+
+    *formatContext = avformat_alloc_context();
+    if (!*formatContext)
+    {
+      freeIoContext(ioContext);
+      return AVERROR(ENOMEM);
+    }
+
+    (*formatContext)->pb = ioContext;
+
+    // The name is still passed along, it becomes the context's url and helps guessing the format
+    const int result = avformat_open_input(formatContext, mediaFile.c_str(), nullptr, nullptr);
+    if (result < 0)
+    {
+      // The format context is already freed, but a custom I/O context never is
+      freeIoContext(ioContext);
+    }
+
+    return result;
+  }
+
+  void close(AVFormatContext** formatContext)
+  {
+    if (!*formatContext)
+    {
+      return;
+    }
+
+    AVIOContext* ioContext = (*formatContext)->flags & AVFMT_FLAG_CUSTOM_IO ? (*formatContext)->pb : nullptr;
+
+    avformat_close_input(formatContext);
+
+    if (ioContext)
+    {
+      freeIoContext(ioContext);
+    }
+  }
+
+  void setAccessPattern(const std::string& mediaFile, const AccessPattern pattern)
+  {
+    const std::string key = getMappingKey(mediaFile);
+
+    std::shared_ptr<MappedFile> mapping;
+    {
+      std::lock_guard lock(mappingsMutex);
+
+      if (const auto it = mappings.find(key); it != mappings.end())
+      {
+        mapping = it->second.lock();
+      }
+    }
+
+    if (mapping)
+    {
+      mapping->advise(pattern);
+    }
+  }
+} // AVParser::MediaInput
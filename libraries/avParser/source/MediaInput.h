@@ -0,0 +1,26 @@
+#ifndef MEDIAINPUT_H
+#define MEDIAINPUT_H
+
+#include "MappedFile.h"
+extern "C" {
+#include <libavformat/avformat.h>
+}
+#include <string>
+
+namespace AVParser::MediaInput {
+
+// Opens a demuxer like avformat_open_input, but reads a local file straight from a memory mapping shared by every
+// reader of the file instead of through FFmpeg's buffered file protocol. Anything that can't be mapped (e.g. a URL) is
+// opened by FFmpeg itself. Returns a negative AVERROR on failure
+[[nodiscard]] int open(AVFormatContext** formatContext, const std::string& mediaFile);
+
+// Closes a demuxer opened with open, like avformat_close_input
+void close(AVFormatContext** formatContext);
+
+// Hints how the file is about to be read by all of its readers, e.g. sequentially while playing and randomly while
+// scrubbing. Does nothing if nobody has the file mapped
+void setAccessPattern(const std::string& mediaFile, AccessPattern pattern);
+
+} // AVParser::MediaInput
+
+#endif //MEDIAINPUT_H
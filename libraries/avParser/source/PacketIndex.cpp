@@ -0,0 +1,430 @@
+#include "PacketIndex.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace AVParser {
+  constexpr char indexMagic[8] = { 'M', 'E', 'D', 'O', 'S', 'I', 'D', 'X' };
+
+  // Bump whenever the layout of the file or of the entries changes
+  constexpr uint32_t indexVersion = 2;
+
+  struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint16_t packetEntrySize;
+    uint16_t keyFrameEntrySize;
+    IndexCache::MediaFileKey key;
+    int32_t videoStreamIndex;
+    int32_t audioStreamIndex;
+    AVRational videoTimeBase;
+    AVRational audioTimeBase;
+    uint64_t packetCount;
+    uint64_t videoFrameCount;
+    uint64_t audioPacketCount;
+    uint64_t keyFrameCount;
+  };
+
+  // Arrays follow the header back to back, keep every section 8 byte aligned so they can be used in place
+  static_assert(sizeof(IndexFileHeader) % 8 == 0);
+  static_assert(sizeof(PacketEntry) % 8 == 0);
+  static_assert(sizeof(KeyFrameEntry) % 8 == 0);
+
+  // Written byte for byte, so none of them may have padding that would leave garbage in the file
+  static_assert(std::has_unique_object_representations_v<IndexFileHeader>);
+  static_assert(std::has_unique_object_representations_v<PacketEntry>);
+  static_assert(std::has_unique_object_representations_v<KeyFrameEntry>);
+
+  namespace {
+    // A time converted back from a PTS may land a hair below it, which must not round down to the previous PTS
+    int64_t secondsToPts(const double seconds, const AVRational timeBase)
+    {
+      return static_cast<int64_t>(std::floor(seconds / av_q2d(timeBase) + 1e-6));
+    }
+  }
+
+  PacketIndex::PacketIndex() = default;
+
+  PacketIndex::~PacketIndex() = default;
+
+  PacketIndex::PacketIndex(PacketIndex&&) noexcept = default;
+
+  PacketIndex& PacketIndex::operator=(PacketIndex&&) noexcept = default;
+
+  void PacketIndex::build(AVFormatContext* formatContext, const int videoStreamIndex, const int audioStreamIndex)
+  {
+    if (av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD) < 0)
+    {
+      throw std::runtime_error("Failed to seek to the start of the file for indexing!");
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet)
+    {
+      throw std::runtime_error("Failed to allocate packet for indexing!");
+    }
+
+    std::vector<PacketEntry> entries;
+
+    // Single demux pass, no decoding
+    while (av_read_frame(formatContext, packet) >= 0)
+    {
+      if (packet->stream_index == videoStreamIndex || packet->stream_index == audioStreamIndex)
+      {
+        entries.push_back({
+          .pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts,
+          .dts = packet->dts,
+          .pos = packet->pos,
+          .size = packet->size,
+          .streamIndex = packet->stream_index,
+          .flags = packet->flags
+        });
+      }
+      av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+
+    // Reset stream position
+    av_seek_frame(formatContext, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
+
+    assign(std::move(entries), videoStreamIndex, audioStreamIndex, formatContext->streams[videoStreamIndex]->time_base,
+           formatContext->streams[audioStreamIndex]->time_base);
+  }
+
+  void PacketIndex::assign(std::vector<PacketEntry> entries, const int videoStreamIndex, const int audioStreamIndex,
+                           const AVRational videoTimeBase, const AVRational audioTimeBase)
+  {
+    clear();
+
+    this->videoStreamIndex = videoStreamIndex;
+    this->audioStreamIndex = audioStreamIndex;
+    this->videoTimeBase = videoTimeBase;
+    this->audioTimeBase = audioTimeBase;
+
+    packetStorage = std::move(entries);
+
+    finalize();
+  }
+
+  bool PacketIndex::load(const std::filesystem::path& indexFile, const IndexCache::MediaFileKey& key,
+                         const int videoStreamIndex, const int audioStreamIndex)
+  {
+    clear();
+
+    std::error_code error;
+    if (!std::filesystem::exists(indexFile, error))
+    {
+      return false;
+    }
+
+    std::unique_ptr<MappedFile> mapping;
+    try
+    {
+      mapping = std::make_unique<MappedFile>(indexFile.string());
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+
+    if (mapping->size() < sizeof(IndexFileHeader))
+    {
+      return false;
+    }
+
+    IndexFileHeader header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 || header.version != indexVersion ||
+        header.packetEntrySize != sizeof(PacketEntry) || header.keyFrameEntrySize != sizeof(KeyFrameEntry) ||
+        header.key != key || header.videoStreamIndex != videoStreamIndex ||
+        header.audioStreamIndex != audioStreamIndex)
+    {
+      return false;
+    }
+
+    const size_t expectedSize = sizeof(IndexFileHeader) +
+                                header.packetCount * sizeof(PacketEntry) +
+                                (header.videoFrameCount + header.audioPacketCount) * sizeof(int64_t) +
+                                header.keyFrameCount * sizeof(KeyFrameEntry);
+    if (mapping->size() != expectedSize)
+    {
+      return false;
+    }
+
+    const uint8_t* data = mapping->data() + sizeof(IndexFileHeader);
+
+    packets = { reinterpret_cast<const PacketEntry*>(data), header.packetCount };
+    data += header.packetCount * sizeof(PacketEntry);
+
+    videoPts = { reinterpret_cast<const int64_t*>(data), header.videoFrameCount };
+    data += header.videoFrameCount * sizeof(int64_t);
+
+    audioPts = { reinterpret_cast<const int64_t*>(data), header.audioPacketCount };
+    data += header.audioPacketCount * sizeof(int64_t);
+
+    keyFrames = { reinterpret_cast<const KeyFrameEntry*>(data), header.keyFrameCount };
+
+    this->videoStreamIndex = videoStreamIndex;
+    this->audioStreamIndex = audioStreamIndex;
+    videoTimeBase = header.videoTimeBase;
+    audioTimeBase = header.audioTimeBase;
+    mappedIndex = std::move(mapping);
+
+    updateStartTime();
+
+    return true;
+  }
+
+  bool PacketIndex::save(const std::filesystem::path& indexFile, const IndexCache::MediaFileKey& key) const
+  {
+    if (empty())
+    {
+      return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(indexFile.parent_path(), error);
+
+    IndexFileHeader header {
+      .magic = {},
+      .version = indexVersion,
+      .packetEntrySize = sizeof(PacketEntry),
+      .keyFrameEntrySize = sizeof(KeyFrameEntry),
+      .key = key,
+      .videoStreamIndex = videoStreamIndex,
+      .audioStreamIndex = audioStreamIndex,
+      .videoTimeBase = videoTimeBase,
+      .audioTimeBase = audioTimeBase,
+      .packetCount = packets.size(),
+      .videoFrameCount = videoPts.size(),
+      .audioPacketCount = audioPts.size(),
+      .keyFrameCount = keyFrames.size()
+    };
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+
+    // Write next to the target and rename, so a reader never maps a partially written index
+    const auto tempFile = IndexCache::getTempPath(indexFile);
+
+    {
+      std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+      if (!file.is_open())
+      {
+        return false;
+      }
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(packets.data()), static_cast<std::streamsize>(packets.size_bytes()));
+      file.write(reinterpret_cast<const char*>(videoPts.data()), static_cast<std::streamsize>(videoPts.size_bytes()));
+      file.write(reinterpret_cast<const char*>(audioPts.data()), static_cast<std::streamsize>(audioPts.size_bytes()));
+      file.write(reinterpret_cast<const char*>(keyFrames.data()), static_cast<std::streamsize>(keyFrames.size_bytes()));
+
+      if (!file)
+      {
+        file.close();
+        std::filesystem::remove(tempFile, error);
+        return false;
+      }
+    }
+
+    std::filesystem::rename(tempFile, indexFile, error);
+    if (error)
+    {
+      std::filesystem::remove(tempFile, error);
+      return false;
+    }
+
+    return true;
+  }
+
+  void PacketIndex::clear()
+  {
+    packets = {};
+    videoPts = {};
+    audioPts = {};
+    keyFrames = {};
+    startTime = 0;
+
+    packetStorage.clear();
+    videoPtsStorage.clear();
+    audioPtsStorage.clear();
+    keyFrameStorage.clear();
+    mappedIndex.reset();
+  }
+
+  bool PacketIndex::empty() const
+  {
+    return videoPts.empty();
+  }
+
+  std::span<const PacketEntry> PacketIndex::getPackets() const
+  {
+    return packets;
+  }
+
+  std::span<const KeyFrameEntry> PacketIndex::getKeyFrames() const
+  {
+    return keyFrames;
+  }
+
+  uint32_t PacketIndex::getVideoFrameCount() const
+  {
+    return static_cast<uint32_t>(videoPts.size());
+  }
+
+  int64_t PacketIndex::getFramePts(const uint32_t frameIndex) const
+  {
+    if (videoPts.empty())
+    {
+      throw std::runtime_error("Packet index is empty!");
+    }
+
+    return videoPts[std::min<size_t>(frameIndex, videoPts.size() - 1)];
+  }
+
+  double PacketIndex::getFrameTime(const uint32_t frameIndex) const
+  {
+    return static_cast<double>(getFramePts(frameIndex)) * av_q2d(videoTimeBase) - startTime;
+  }
+
+  uint32_t PacketIndex::findFrame(const double seconds) const
+  {
+    if (videoPts.empty() || !(seconds > 0))
+    {
+      return 0;
+    }
+
+    const auto pts = std::isfinite(seconds) ? secondsToPts(seconds + startTime, videoTimeBase)
+                                            : std::numeric_limits<int64_t>::max();
+    const auto it = std::ranges::upper_bound(videoPts, pts);
+
+    return static_cast<uint32_t>(std::max<ptrdiff_t>(std::distance(videoPts.begin(), it) - 1, 0));
+  }
+
+  double PacketIndex::getAudioTime(const int64_t pts) const
+  {
+    if (audioPts.empty())
+    {
+      return 0;
+    }
+
+    return static_cast<double>(pts) * av_q2d(audioTimeBase) - startTime;
+  }
+
+  double PacketIndex::getAudioStartTime() const
+  {
+    return getAudioTime(audioPts.empty() ? 0 : audioPts.front());
+  }
+
+  int64_t PacketIndex::findAudioPts(const double seconds) const
+  {
+    if (audioPts.empty())
+    {
+      return 0;
+    }
+
+    const auto it = std::ranges::lower_bound(audioPts, audioTimeToPts(seconds));
+
+    return it != audioPts.end() ? *it : audioPts.back();
+  }
+
+  uint32_t PacketIndex::countAudioPackets(const double startSeconds, const double endSeconds) const
+  {
+    const auto first = std::ranges::lower_bound(audioPts, audioTimeToPts(startSeconds));
+    const auto last = std::lower_bound(first, audioPts.end(), audioTimeToPts(endSeconds));
+
+    return static_cast<uint32_t>(std::distance(first, last));
+  }
+
+  void PacketIndex::finalize()
+  {
+    int64_t firstKeyFramePts = AV_NOPTS_VALUE;
+
+    for (const auto& entry : packetStorage)
+    {
+      if (entry.streamIndex == videoStreamIndex && entry.flags & AV_PKT_FLAG_KEY && entry.pts != AV_NOPTS_VALUE)
+      {
+        firstKeyFramePts = entry.pts;
+        break;
+      }
+    }
+
+    for (const auto& entry : packetStorage)
+    {
+      if (entry.pts == AV_NOPTS_VALUE)
+      {
+        continue;
+      }
+
+      if (entry.streamIndex == audioStreamIndex)
+      {
+        audioPtsStorage.push_back(entry.pts);
+      }
+      // Frames presented before the first keyframe can't be decoded, so the first keyframe becomes frame 0
+      else if (firstKeyFramePts != AV_NOPTS_VALUE && entry.pts >= firstKeyFramePts)
+      {
+        videoPtsStorage.push_back(entry.pts);
+      }
+    }
+
+    std::ranges::sort(videoPtsStorage);
+    std::ranges::sort(audioPtsStorage);
+
+    for (const auto& entry : packetStorage)
+    {
+      if (entry.streamIndex != videoStreamIndex || !(entry.flags & AV_PKT_FLAG_KEY) ||
+          entry.pts == AV_NOPTS_VALUE || entry.pts < firstKeyFramePts)
+      {
+        continue;
+      }
+
+      const auto it = std::ranges::lower_bound(videoPtsStorage, entry.pts);
+
+      keyFrameStorage.push_back({
+        .frame = static_cast<uint32_t>(std::distance(videoPtsStorage.begin(), it)),
+        .pts = entry.pts
+      });
+    }
+
+    std::ranges::sort(keyFrameStorage, {}, &KeyFrameEntry::frame);
+
+    packets = packetStorage;
+    videoPts = videoPtsStorage;
+    audioPts = audioPtsStorage;
+    keyFrames = keyFrameStorage;
+
+    updateStartTime();
+  }
+
+  void PacketIndex::updateStartTime()
+  {
+    startTime = videoPts.empty() ? 0 : static_cast<double>(videoPts.front()) * av_q2d(videoTimeBase);
+
+    if (!audioPts.empty())
+    {
+      const double audioStart = static_cast<double>(audioPts.front()) * av_q2d(audioTimeBase);
+      startTime = videoPts.empty() ? audioStart : std::min(startTime, audioStart);
+    }
+  }
+
+  int64_t PacketIndex::audioTimeToPts(const double seconds) const
+  {
+    if (audioPts.empty())
+    {
+      return 0;
+    }
+
+    if (!std::isfinite(seconds))
+    {
+      return std::numeric_limits<int64_t>::max();
+    }
+
+    return secondsToPts(seconds + startTime, audioTimeBase);
+  }
+} // AVParser
@@ -0,0 +1,123 @@
+#ifndef PACKETINDEX_H
+#define PACKETINDEX_H
+
+#include "IndexCache.h"
+extern "C" {
+#include <libavformat/avformat.h>
+}
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace AVParser {
+
+class MappedFile;
+
+// Entries are written to the index file as they are, padding is spelled out so no uninitialized bytes end up on disk
+struct PacketEntry {
+  int64_t pts;
+  int64_t dts;
+  int64_t pos;
+  int32_t size;
+  int32_t streamIndex;
+  int32_t flags;
+  int32_t reserved = 0;
+};
+
+struct KeyFrameEntry {
+  uint32_t frame;
+  uint32_t reserved = 0;
+  int64_t pts;
+};
+
+class PacketIndex {
+public:
+  PacketIndex();
+
+  ~PacketIndex();
+
+  // Moving keeps the storage the spans point into
+  PacketIndex(PacketIndex&&) noexcept;
+  PacketIndex& operator=(PacketIndex&&) noexcept;
+
+  // Reads every packet of the container once and records its timing and position
+  void build(AVFormatContext* formatContext, int videoStreamIndex, int audioStreamIndex);
+
+  // Indexes packets that were already read, e.g. the part of the file an IndexBuilder got through so far
+  void assign(std::vector<PacketEntry> entries, int videoStreamIndex, int audioStreamIndex, AVRational videoTimeBase,
+              AVRational audioTimeBase);
+
+  // Maps a previously saved index, returns false if it is missing or does not match the key
+  bool load(const std::filesystem::path& indexFile, const IndexCache::MediaFileKey& key,
+            int videoStreamIndex, int audioStreamIndex);
+
+  bool save(const std::filesystem::path& indexFile, const IndexCache::MediaFileKey& key) const;
+
+  void clear();
+
+  [[nodiscard]] bool empty() const;
+
+  [[nodiscard]] std::span<const PacketEntry> getPackets() const;
+
+  [[nodiscard]] std::span<const KeyFrameEntry> getKeyFrames() const;
+
+  [[nodiscard]] uint32_t getVideoFrameCount() const;
+
+  [[nodiscard]] int64_t getFramePts(uint32_t frameIndex) const;
+
+  // Times in seconds are measured from the start of the file, whichever of the first frame and the first audio
+  // packet comes first, so video and audio times can be compared directly
+
+  // Presentation time of a frame in seconds
+  [[nodiscard]] double getFrameTime(uint32_t frameIndex) const;
+
+  // Last frame presented at or before the given time
+  [[nodiscard]] uint32_t findFrame(double seconds) const;
+
+  // Time of an audio PTS in seconds
+  [[nodiscard]] double getAudioTime(int64_t pts) const;
+
+  // Time of the first audio packet in seconds, 0 without audio
+  [[nodiscard]] double getAudioStartTime() const;
+
+  // PTS of the first audio packet at or after the given time
+  [[nodiscard]] int64_t findAudioPts(double seconds) const;
+
+  [[nodiscard]] uint32_t countAudioPackets(double startSeconds, double endSeconds) const;
+
+private:
+  // Backing storage, either built in memory or mapped from an index file
+  std::vector<PacketEntry> packetStorage;
+  std::vector<int64_t> videoPtsStorage;
+  std::vector<int64_t> audioPtsStorage;
+  std::vector<KeyFrameEntry> keyFrameStorage;
+  std::unique_ptr<MappedFile> mappedIndex;
+
+  std::span<const PacketEntry> packets;
+
+  // Video PTS in presentation order, the position in this list is the frame number
+  std::span<const int64_t> videoPts;
+  std::span<const int64_t> audioPts;
+  std::span<const KeyFrameEntry> keyFrames;
+
+  int videoStreamIndex = -1;
+  int audioStreamIndex = -1;
+
+  AVRational videoTimeBase{0, 1};
+  AVRational audioTimeBase{0, 1};
+
+  // Start of the file in seconds of the streams' own timestamps
+  double startTime = 0;
+
+  void finalize();
+
+  void updateStartTime();
+
+  [[nodiscard]] int64_t audioTimeToPts(double seconds) const;
+};
+
+} // AVParser
+
+#endif //PACKETINDEX_H
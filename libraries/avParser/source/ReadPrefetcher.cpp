@@ -0,0 +1,271 @@
+#include "ReadPrefetcher.h"
+#include <algorithm>
+#include <numeric>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef AVPARSER_IO_URING
+#include <liburing.h>
+#endif
+
+namespace AVParser {
+  // Ranges are read in chunks of this size, with io_uring each one is a read of its own
+  constexpr uint32_t chunkSize = 512 * 1024;
+
+  // How many of the last ranges are skipped when they are requested again
+  constexpr size_t recentRangeCount = 64;
+
+#ifdef AVPARSER_IO_URING
+  struct ReadPrefetcher::Ring {
+    io_uring ring{};
+
+    // One chunk for every read in flight
+    std::vector<uint8_t> buffers;
+  };
+#else
+  struct ReadPrefetcher::Ring {};
+#endif
+
+  ReadPrefetcher::ReadPrefetcher(const std::string& mediaFile, const ReadBackend backend, const uint32_t queueDepth)
+    : backend(backend), queueDepth(std::max(queueDepth, 1u))
+  {
+#ifdef _WIN32
+    // Windows reads ahead through the file mapping by itself
+    this->backend = ReadBackend::NONE;
+#else
+    if (backend == ReadBackend::NONE)
+    {
+      return;
+    }
+
+    fileDescriptor = ::open(mediaFile.c_str(), O_RDONLY | O_CLOEXEC);
+
+    struct stat fileStat{};
+    if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStat) < 0)
+    {
+      // Only a hint, without it the demuxers read the file themselves
+      if (fileDescriptor >= 0)
+      {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+      }
+
+      this->backend = ReadBackend::NONE;
+      return;
+    }
+
+    fileSize = fileStat.st_size;
+
+    if (backend == ReadBackend::IO_URING)
+    {
+#ifdef AVPARSER_IO_URING
+      ring = std::make_unique<Ring>();
+
+      // Fails e.g. on old kernels or where io_uring is disabled, like in many containers
+      if (io_uring_queue_init(this->queueDepth, &ring->ring, 0) < 0)
+      {
+        ring.reset();
+        this->backend = ReadBackend::PREAD;
+      }
+      else
+      {
+        ring->buffers.resize(static_cast<size_t>(this->queueDepth) * chunkSize);
+      }
+#else
+      this->backend = ReadBackend::PREAD;
+#endif
+    }
+
+    if (this->backend == ReadBackend::IO_URING)
+    {
+      worker = std::thread(&ReadPrefetcher::readWithRing, this);
+    }
+    else
+    {
+      worker = std::thread(&ReadPrefetcher::readWithPread, this);
+    }
+#endif
+  }
+
+  ReadPrefetcher::~ReadPrefetcher()
+  {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+
+    chunkAvailable.notify_all();
+
+    if (worker.joinable())
+    {
+      worker.join();
+    }
+
+#ifdef AVPARSER_IO_URING
+    if (ring)
+    {
+      io_uring_queue_exit(&ring->ring);
+    }
+#endif
+
+#ifndef _WIN32
+    if (fileDescriptor >= 0)
+    {
+      ::close(fileDescriptor);
+    }
+#endif
+  }
+
+  void ReadPrefetcher::prefetch(const int64_t begin, int64_t end)
+  {
+    end = std::min(end, fileSize);
+
+    if (backend == ReadBackend::NONE || begin < 0 || begin >= end)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard lock(mutex);
+
+      if (std::ranges::find(recentRanges, begin) != recentRanges.end())
+      {
+        return;
+      }
+
+      recentRanges.push_back(begin);
+      if (recentRanges.size() > recentRangeCount)
+      {
+        recentRanges.pop_front();
+      }
+
+      for (int64_t offset = begin; offset < end; offset += chunkSize)
+      {
+        chunks.push_back({ offset, static_cast<uint32_t>(std::min<int64_t>(chunkSize, end - offset)) });
+      }
+    }
+
+    chunkAvailable.notify_one();
+  }
+
+  void ReadPrefetcher::cancel()
+  {
+    std::lock_guard lock(mutex);
+
+    chunks.clear();
+
+    // Whatever wasn't read yet may be requested again after the seek
+    recentRanges.clear();
+  }
+
+  ReadBackend ReadPrefetcher::getBackend() const
+  {
+    return backend;
+  }
+
+  bool ReadPrefetcher::isIoUringAvailable()
+  {
+#ifdef AVPARSER_IO_URING
+    io_uring probe{};
+    if (io_uring_queue_init(1, &probe, 0) < 0)
+    {
+      return false;
+    }
+
+    io_uring_queue_exit(&probe);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  std::optional<ReadPrefetcher::Chunk> ReadPrefetcher::nextChunk(const bool wait)
+  {
+    std::unique_lock lock(mutex);
+
+    if (wait)
+    {
+      chunkAvailable.wait(lock, [this] { return stopping || !chunks.empty(); });
+    }
+
+    if (stopping || chunks.empty())
+    {
+      return std::nullopt;
+    }
+
+    const Chunk chunk = chunks.front();
+    chunks.pop_front();
+
+    return chunk;
+  }
+
+  void ReadPrefetcher::readWithPread()
+  {
+#ifndef _WIN32
+    std::vector<uint8_t> buffer(chunkSize);
+
+    while (const auto chunk = nextChunk(true))
+    {
+      // Only read to get the data into the page cache, a failed read just leaves it to the demuxer
+      [[maybe_unused]] const auto bytesRead = pread(fileDescriptor, buffer.data(), chunk->size, chunk->offset);
+    }
+#endif
+  }
+
+  void ReadPrefetcher::readWithRing()
+  {
+#ifdef AVPARSER_IO_URING
+    std::vector<uint32_t> freeSlots(queueDepth);
+    std::iota(freeSlots.begin(), freeSlots.end(), 0u);
+
+    uint32_t inFlight = 0;
+
+    while (true)
+    {
+      // Keep every slot busy, only block for new chunks while nothing is being read
+      while (!freeSlots.empty())
+      {
+        const auto chunk = nextChunk(inFlight == 0);
+        if (!chunk)
+        {
+          break;
+        }
+
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring->ring);
+
+        const uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+
+        io_uring_prep_read(sqe, fileDescriptor, ring->buffers.data() + static_cast<size_t>(slot) * chunkSize,
+                           chunk->size, static_cast<uint64_t>(chunk->offset));
+        sqe->user_data = slot;
+        inFlight++;
+      }
+
+      // Nothing in flight and no chunk to wait for means the prefetcher is stopping
+      if (inFlight == 0)
+      {
+        return;
+      }
+
+      io_uring_submit(&ring->ring);
+
+      io_uring_cqe* cqe = nullptr;
+      if (io_uring_wait_cqe(&ring->ring, &cqe) < 0)
+      {
+        // Interrupted, wait again
+        continue;
+      }
+
+      // The result doesn't matter, a failed read just leaves it to the demuxer
+      freeSlots.push_back(static_cast<uint32_t>(cqe->user_data));
+      io_uring_cqe_seen(&ring->ring, cqe);
+      inFlight--;
+    }
+#endif
+  }
+} // AVParser
@@ -0,0 +1,81 @@
+#ifndef READPREFETCHER_H
+#define READPREFETCHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AVParser {
+
+enum class ReadBackend {
+  NONE,     // Leave it to the demuxers and the OS's read-ahead
+  PREAD,    // One blocking read at a time on a thread of its own
+  IO_URING  // Several reads in flight at once, Linux only and if built with AVPARSER_IO_URING, falls back to PREAD
+};
+
+// Reads byte ranges of a file ahead of the demuxers, so their reads are served from the page cache instead of blocking
+// on a slow disk or network storage. The data itself is thrown away
+class ReadPrefetcher {
+public:
+  // queueDepth is the number of reads in flight with io_uring
+  ReadPrefetcher(const std::string& mediaFile, ReadBackend backend, uint32_t queueDepth);
+
+  ~ReadPrefetcher();
+
+  ReadPrefetcher(const ReadPrefetcher&) = delete;
+  ReadPrefetcher& operator=(const ReadPrefetcher&) = delete;
+
+  // Queues [begin, end) to be read, end is clamped to the file size. Ranges read recently are skipped
+  void prefetch(int64_t begin, int64_t end);
+
+  // Drops the queued ranges, e.g. after a seek. Reads already in flight still finish
+  void cancel();
+
+  // The backend actually used, io_uring falls back to pread if it isn't built in or the kernel doesn't allow it
+  [[nodiscard]] ReadBackend getBackend() const;
+
+  [[nodiscard]] static bool isIoUringAvailable();
+
+private:
+  struct Chunk {
+    int64_t offset;
+    uint32_t size;
+  };
+
+  struct Ring;
+
+  ReadBackend backend;
+  uint32_t queueDepth;
+
+  int fileDescriptor = -1;
+  int64_t fileSize = 0;
+
+  std::unique_ptr<Ring> ring;
+
+  std::mutex mutex;
+  std::condition_variable chunkAvailable;
+  std::deque<Chunk> chunks;
+  bool stopping = false;
+
+  // Starts of the most recent ranges, so GOPs requested again aren't read twice
+  std::deque<int64_t> recentRanges;
+
+  std::thread worker;
+
+  // The next chunk to read, waits for one if wait is set. nullopt when there is none or the prefetcher stops
+  [[nodiscard]] std::optional<Chunk> nextChunk(bool wait);
+
+  void readWithPread();
+
+  void readWithRing();
+};
+
+} // AVParser
+
+#endif //READPREFETCHER_H
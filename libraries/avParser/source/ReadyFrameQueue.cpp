@@ -0,0 +1,71 @@
+#include "ReadyFrameQueue.h"
+#include <stdexcept>
+
+namespace AVParser {
+  ReadyFrameQueue::ReadyFrameQueue(const size_t capacity)
+    : slots(capacity)
+  {
+    if (capacity == 0)
+    {
+      throw std::invalid_argument("Ready frame queue needs at least one slot!");
+    }
+  }
+
+  bool ReadyFrameQueue::push(ReadyFrame frame)
+  {
+    const size_t currentTail = tail.load(std::memory_order_relaxed);
+
+    // Acquire so the consumer is done with the slot before it is overwritten
+    if (currentTail - head.load(std::memory_order_acquire) == slots.size())
+    {
+      return false;
+    }
+
+    slots[currentTail % slots.size()] = std::move(frame);
+    tail.store(currentTail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  ReadyFrame* ReadyFrameQueue::front()
+  {
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+
+    if (currentHead == tail.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    return &slots[currentHead % slots.size()];
+  }
+
+  void ReadyFrameQueue::pop()
+  {
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+
+    if (currentHead == tail.load(std::memory_order_acquire))
+    {
+      return;
+    }
+
+    // Release the buffer here rather than when the slot is reused, so the pool can recycle it
+    slots[currentHead % slots.size()] = {};
+    head.store(currentHead + 1, std::memory_order_release);
+  }
+
+  void ReadyFrameQueue::clear()
+  {
+    for (auto& slot : slots)
+    {
+      slot = {};
+    }
+
+    head = 0;
+    tail = 0;
+  }
+
+  bool ReadyFrameQueue::full() const
+  {
+    return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == slots.size();
+  }
+} // AVParser
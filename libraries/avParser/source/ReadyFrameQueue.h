@@ -0,0 +1,55 @@
+#ifndef READYFRAMEQUEUE_H
+#define READYFRAMEQUEUE_H
+
+#include "FrameBufferPool.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace AVParser {
+
+// A decoded frame that can be shown as is
+struct ReadyFrame {
+  uint32_t frameIndex = 0;
+  int64_t pts = 0;
+  FrameBuffer buffer;
+  uint64_t seekEpoch = 0; // Frames queued before the last seek are stale
+};
+
+// Bounded lock-free queue with exactly one producer thread (the frame loader) and one consumer thread (the player).
+// Neither side ever blocks, a full queue refuses the push and an empty one returns nullptr
+class ReadyFrameQueue {
+public:
+  explicit ReadyFrameQueue(size_t capacity);
+
+  ReadyFrameQueue(const ReadyFrameQueue&) = delete;
+  ReadyFrameQueue& operator=(const ReadyFrameQueue&) = delete;
+
+  // Producer only, returns false if the queue is full
+  bool push(ReadyFrame frame);
+
+  // Consumer only, the oldest frame or nullptr. Valid until the next pop
+  [[nodiscard]] ReadyFrame* front();
+
+  // Consumer only, drops the oldest frame and its buffer reference
+  void pop();
+
+  // Only while neither thread uses the queue
+  void clear();
+
+  [[nodiscard]] bool full() const;
+
+private:
+  // Keeps the two indices on separate cache lines so the threads don't invalidate each other's
+  static constexpr size_t cacheLineSize = 64;
+
+  std::vector<ReadyFrame> slots;
+
+  // Indices grow without wrapping, the slot is the index modulo the slot count
+  alignas(cacheLineSize) std::atomic<size_t> head = 0;
+  alignas(cacheLineSize) std::atomic<size_t> tail = 0;
+};
+
+} // AVParser
+
+#endif //READYFRAMEQUEUE_H
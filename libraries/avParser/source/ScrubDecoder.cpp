@@ -0,0 +1,166 @@
+#include "ScrubDecoder.h"
+#include <algorithm>
+
+namespace AVParser {
+  ScrubDecoder::ScrubDecoder(const std::string& mediaFile, const int videoStreamIndex, const FrameFormat frameFormat,
+                             const int maxWidth, const int maxHeight, const size_t cacheSize)
+    : decoder(mediaFile, videoStreamIndex, frameFormat, maxWidth, maxHeight), cacheSize(std::max<size_t>(cacheSize, 1)),
+      scheduler(DecodeScheduler::getShared())
+  {}
+
+  ScrubDecoder::~ScrubDecoder()
+  {
+    scheduler.cancel(this);
+  }
+
+  void ScrubDecoder::request(const uint32_t keyFrame, const int64_t keyFramePts)
+  {
+    std::lock_guard lock(mutex);
+
+    if (isKnown(keyFrame))
+    {
+      return;
+    }
+
+    pendingRequest = ScrubRequest{ keyFrame, keyFramePts };
+    scheduleDecode();
+  }
+
+  void ScrubDecoder::prefetch(std::vector<KeyFrameEntry> keyFrames)
+  {
+    std::lock_guard lock(mutex);
+
+    prefetchQueue.assign(keyFrames.begin(), keyFrames.end());
+    scheduleDecode();
+  }
+
+  FrameBuffer ScrubDecoder::find(const uint32_t keyFrame) const
+  {
+    std::lock_guard lock(mutex);
+
+    const auto it = std::ranges::find(previews, keyFrame, &std::pair<uint32_t, FrameBuffer>::first);
+    return it != previews.end() ? it->second : nullptr;
+  }
+
+  std::pair<uint32_t, FrameBuffer> ScrubDecoder::findClosest(const uint32_t from, const uint32_t to) const
+  {
+    std::lock_guard lock(mutex);
+
+    const auto distance = [to](const uint32_t keyFrame) { return keyFrame > to ? keyFrame - to : to - keyFrame; };
+
+    std::pair<uint32_t, FrameBuffer> closest{ 0, nullptr };
+    for (const auto& [keyFrame, preview] : previews)
+    {
+      if (keyFrame < std::min(from, to) || keyFrame > std::max(from, to))
+      {
+        continue;
+      }
+
+      if (!closest.second || distance(keyFrame) < distance(closest.first))
+      {
+        closest = { keyFrame, preview };
+      }
+    }
+
+    return closest;
+  }
+
+  int ScrubDecoder::getWidth() const
+  {
+    return decoder.getWidth();
+  }
+
+  int ScrubDecoder::getHeight() const
+  {
+    return decoder.getHeight();
+  }
+
+  void ScrubDecoder::scheduleDecode()
+  {
+    // The task decoding now schedules the next one once it is done
+    if (decodingKeyFrame)
+    {
+      return;
+    }
+
+    // A request gets a task of its own, so it passes the prefetching of every file
+    if (pendingRequest && !requestTaskQueued)
+    {
+      scheduler.submit(this, DecodePriority::PLAYHEAD, [this] { decodeNext(true); });
+      requestTaskQueued = true;
+    }
+    else if (!pendingRequest && !prefetchQueue.empty() && !requestTaskQueued && !prefetchTaskQueued)
+    {
+      scheduler.submit(this, DecodePriority::PREFETCH, [this] { decodeNext(false); });
+      prefetchTaskQueued = true;
+    }
+  }
+
+  void ScrubDecoder::decodeNext(const bool requestTask)
+  {
+    ScrubRequest scrubRequest{};
+
+    {
+      std::lock_guard lock(mutex);
+
+      (requestTask ? requestTaskQueued : prefetchTaskQueued) = false;
+
+      // Another task is decoding, it schedules whatever is left once it is done
+      if (decodingKeyFrame)
+      {
+        return;
+      }
+
+      // Prefetched keyframes that were decoded meanwhile are skipped
+      while (!pendingRequest && !prefetchQueue.empty())
+      {
+        const KeyFrameEntry next = prefetchQueue.front();
+        prefetchQueue.pop_front();
+
+        if (!isKnown(next.frame))
+        {
+          pendingRequest = ScrubRequest{ next.frame, next.pts };
+        }
+      }
+
+      if (!pendingRequest)
+      {
+        return;
+      }
+
+      scrubRequest = *pendingRequest;
+      pendingRequest.reset();
+      decodingKeyFrame = scrubRequest.keyFrame;
+    }
+
+    FrameBuffer preview;
+    try
+    {
+      preview = decoder.decode(scrubRequest.keyFramePts);
+    }
+    catch ([[maybe_unused]] const std::exception& e)
+    { /* No preview for this keyframe, the exact frame is still loaded when the scrub ends */ }
+
+    std::lock_guard lock(mutex);
+
+    decodingKeyFrame.reset();
+
+    if (preview)
+    {
+      if (previews.size() >= cacheSize)
+      {
+        previews.pop_front();
+      }
+
+      previews.emplace_back(scrubRequest.keyFrame, std::move(preview));
+    }
+
+    scheduleDecode();
+  }
+
+  bool ScrubDecoder::isKnown(const uint32_t keyFrame) const
+  {
+    return decodingKeyFrame == keyFrame ||
+           std::ranges::find(previews, keyFrame, &std::pair<uint32_t, FrameBuffer>::first) != previews.end();
+  }
+} // AVParser
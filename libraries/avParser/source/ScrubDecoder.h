@@ -0,0 +1,85 @@
+#ifndef SCRUBDECODER_H
+#define SCRUBDECODER_H
+
+#include "DecodeScheduler.h"
+#include "KeyFrameDecoder.h"
+#include "PacketIndex.h"
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace AVParser {
+
+// Decodes keyframes only, fitted to a maximum size, for previews while the timeline is dragged and for keyframe only
+// fast playback. Requests are decoded one at a time on the shared DecodeScheduler at playhead priority and a new request
+// replaces the one still waiting, so only the latest position is ever decoded. Keyframes asked for with prefetch are
+// decoded at prefetch priority while no request is waiting
+class ScrubDecoder {
+public:
+  // Keeps the cacheSize most recently decoded keyframes
+  ScrubDecoder(const std::string& mediaFile, int videoStreamIndex, FrameFormat frameFormat, int maxWidth, int maxHeight,
+               size_t cacheSize);
+
+  ~ScrubDecoder();
+
+  ScrubDecoder(const ScrubDecoder&) = delete;
+  ScrubDecoder& operator=(const ScrubDecoder&) = delete;
+
+  // Decodes the preview of the keyframe in the background unless it is cached or being decoded already
+  void request(uint32_t keyFrame, int64_t keyFramePts);
+
+  // Keyframes to decode in this order once the requested one is done, e.g. the ones playback reaches next. Replaces
+  // the ones of the previous call that weren't decoded yet
+  void prefetch(std::vector<KeyFrameEntry> keyFrames);
+
+  // Returns nullptr if the preview isn't decoded yet
+  [[nodiscard]] FrameBuffer find(uint32_t keyFrame) const;
+
+  // The decoded preview closest to the keyframe to among the keyframes from from to to (in either direction) and its
+  // keyframe, nullptr if there is none
+  [[nodiscard]] std::pair<uint32_t, FrameBuffer> findClosest(uint32_t from, uint32_t to) const;
+
+  [[nodiscard]] int getWidth() const;
+
+  [[nodiscard]] int getHeight() const;
+
+private:
+  struct ScrubRequest {
+    uint32_t keyFrame;
+    int64_t keyFramePts;
+  };
+
+  KeyFrameDecoder decoder;
+
+  size_t cacheSize;
+
+  DecodeScheduler& scheduler;
+
+  mutable std::mutex mutex;
+  std::optional<ScrubRequest> pendingRequest;
+  std::deque<KeyFrameEntry> prefetchQueue;
+
+  // Tasks on the scheduler that haven't started yet, at most one of each priority
+  bool requestTaskQueued = false;
+  bool prefetchTaskQueued = false;
+
+  // Keyframe a task is decoding, if any. Only one task decodes at a time, the decoder is shared
+  std::optional<uint32_t> decodingKeyFrame;
+
+  // Most recent previews last, the oldest is dropped once the cache is full
+  std::deque<std::pair<uint32_t, FrameBuffer>> previews;
+
+  // Has the scheduler run a task if there is something to decode and no task would get to it. Called with the mutex held
+  void scheduleDecode();
+
+  // Decodes the pending request, or the next prefetched keyframe that isn't known yet
+  void decodeNext(bool requestTask);
+
+  // Whether the keyframe is cached or being decoded. Called with the mutex held
+  [[nodiscard]] bool isKnown(uint32_t keyFrame) const;
+};
+
+} // AVParser
+
+#endif //SCRUBDECODER_H
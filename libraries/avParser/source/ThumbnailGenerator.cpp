@@ -0,0 +1,299 @@
+#include "ThumbnailGenerator.h"
+#include "KeyFrameDecoder.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace AVParser {
+  // Thumbnails are scaled down to fit this size, keeping the aspect ratio
+  constexpr int thumbnailMaxWidth = 160;
+  constexpr int thumbnailMaxHeight = 90;
+
+  // Files with more keyframes get this many, spread evenly over them
+  constexpr size_t maxThumbnails = 256;
+
+  constexpr char thumbnailMagic[8] = { 'M', 'E', 'D', 'O', 'S', 'T', 'H', 'M' };
+
+  // Bump whenever the layout of the file changes
+  constexpr uint32_t thumbnailVersion = 2;
+
+  // The entries and pixels follow the header back to back
+  struct ThumbnailFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t videoStreamIndex;
+    IndexCache::MediaFileKey key;
+    int32_t width;
+    int32_t height;
+    uint64_t count;
+  };
+
+  // Written byte for byte, padding would leave garbage in the file
+  static_assert(std::has_unique_object_representations_v<ThumbnailFileHeader>);
+
+  ThumbnailGenerator::ThumbnailGenerator(const std::string& mediaFile, const int videoStreamIndex,
+                                         const int frameWidth, const int frameHeight,
+                                         const std::span<const KeyFrameEntry> keyFrames,
+                                         const std::optional<IndexCache::MediaFileKey>& fileKey,
+                                         const uint32_t workerCount)
+    : mediaFile(mediaFile), videoStreamIndex(videoStreamIndex), fileKey(fileKey),
+      scheduler(DecodeScheduler::getShared())
+  {
+    std::tie(width, height) = fitFrameSize(frameWidth, frameHeight, thumbnailMaxWidth, thumbnailMaxHeight);
+
+    const size_t count = std::min(keyFrames.size(), maxThumbnails);
+    thumbnailFrames.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      thumbnailFrames.push_back(keyFrames[i * keyFrames.size() / count]);
+    }
+
+    pixels.resize(count * getThumbnailBytes());
+    ready = std::make_unique<std::atomic<bool>[]>(count);
+
+    if (count == 0 || load())
+    {
+      return;
+    }
+
+    for (uint32_t i = 0; i < std::max(workerCount, 1u); i++)
+    {
+      scheduler.submit(this, DecodePriority::THUMBNAIL, [this] { decodeNext(); });
+    }
+  }
+
+  ThumbnailGenerator::~ThumbnailGenerator()
+  {
+    stopping = true;
+
+    scheduler.cancel(this);
+  }
+
+  uint32_t ThumbnailGenerator::getCount() const
+  {
+    return static_cast<uint32_t>(thumbnailFrames.size());
+  }
+
+  int ThumbnailGenerator::getWidth() const
+  {
+    return width;
+  }
+
+  int ThumbnailGenerator::getHeight() const
+  {
+    return height;
+  }
+
+  uint32_t ThumbnailGenerator::getFrame(const uint32_t thumbnail) const
+  {
+    return thumbnailFrames.at(thumbnail).frame;
+  }
+
+  uint32_t ThumbnailGenerator::findThumbnail(const uint32_t frame) const
+  {
+    const auto it = std::ranges::upper_bound(thumbnailFrames, frame, {}, &KeyFrameEntry::frame);
+
+    return it == thumbnailFrames.begin() ? 0 : static_cast<uint32_t>(std::distance(thumbnailFrames.begin(), it) - 1);
+  }
+
+  const uint8_t* ThumbnailGenerator::getPixels(const uint32_t thumbnail) const
+  {
+    if (thumbnail >= getCount() || !ready[thumbnail].load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    return pixels.data() + thumbnail * getThumbnailBytes();
+  }
+
+  bool ThumbnailGenerator::isComplete() const
+  {
+    return finishedThumbnails == getCount();
+  }
+
+  size_t ThumbnailGenerator::getThumbnailBytes() const
+  {
+    return static_cast<size_t>(width) * height * 4;
+  }
+
+  void ThumbnailGenerator::decodeNext()
+  {
+    if (stopping)
+    {
+      return;
+    }
+
+    std::unique_ptr<KeyFrameDecoder> decoder;
+    {
+      std::lock_guard lock(decoderMutex);
+
+      if (!idleDecoders.empty())
+      {
+        decoder = std::move(idleDecoders.back());
+        idleDecoders.pop_back();
+      }
+    }
+
+    if (!decoder)
+    {
+      try
+      {
+        decoder = std::make_unique<KeyFrameDecoder>(mediaFile, videoStreamIndex, FrameFormat::RGBA, width, height);
+      }
+      catch ([[maybe_unused]] const std::exception& e)
+      {
+        return;
+      }
+    }
+
+    // Each task takes the next thumbnail nobody has started on, so the parallel ones finish at about the same time
+    const uint32_t thumbnail = nextThumbnail++;
+    if (thumbnail >= getCount())
+    {
+      return;
+    }
+
+    bool decoded = false;
+    try
+    {
+      decoded = decoder->getWidth() == width && decoder->getHeight() == height &&
+                decoder->decodeInto(thumbnailFrames[thumbnail].pts, pixels.data() + thumbnail * getThumbnailBytes());
+    }
+    catch ([[maybe_unused]] const std::exception& e)
+    { /* Leave the thumbnail out, the timeline falls back to the closest one before it */ }
+
+    if (decoded)
+    {
+      ready[thumbnail].store(true, std::memory_order_release);
+    }
+
+    // The task that finishes the last thumbnail saves them all, unless one of them failed
+    if (++finishedThumbnails == getCount() && std::ranges::all_of(std::span(ready.get(), getCount()),
+        [](const std::atomic<bool>& isReady) { return isReady.load(std::memory_order_acquire); }))
+    {
+      save();
+    }
+
+    {
+      std::lock_guard lock(decoderMutex);
+      idleDecoders.push_back(std::move(decoder));
+    }
+
+    // One thumbnail per task, so playback never waits on the thumbnails for longer than a keyframe decode
+    if (!stopping && nextThumbnail < getCount())
+    {
+      scheduler.submit(this, DecodePriority::THUMBNAIL, [this] { decodeNext(); });
+    }
+  }
+
+  bool ThumbnailGenerator::load()
+  {
+    if (!fileKey)
+    {
+      return false;
+    }
+
+    std::unique_ptr<MappedFile> mapping;
+    try
+    {
+      mapping = std::make_unique<MappedFile>(IndexCache::getCachePath(*fileKey, ".thumbs").string());
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+
+    const size_t framesSize = thumbnailFrames.size() * sizeof(KeyFrameEntry);
+    if (mapping->size() != sizeof(ThumbnailFileHeader) + framesSize + pixels.size())
+    {
+      return false;
+    }
+
+    ThumbnailFileHeader header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, thumbnailMagic, sizeof(thumbnailMagic)) != 0 || header.version != thumbnailVersion ||
+        header.videoStreamIndex != videoStreamIndex || header.key != *fileKey || header.width != width ||
+        header.height != height || header.count != thumbnailFrames.size())
+    {
+      return false;
+    }
+
+    // Compared field by field, the reserved part of the entries isn't meaningful
+    for (size_t i = 0; i < thumbnailFrames.size(); i++)
+    {
+      KeyFrameEntry entry;
+      std::memcpy(&entry, mapping->data() + sizeof(header) + i * sizeof(KeyFrameEntry), sizeof(entry));
+
+      if (entry.frame != thumbnailFrames[i].frame || entry.pts != thumbnailFrames[i].pts)
+      {
+        return false;
+      }
+    }
+
+    std::memcpy(pixels.data(), mapping->data() + sizeof(header) + framesSize, pixels.size());
+
+    for (uint32_t i = 0; i < getCount(); i++)
+    {
+      ready[i].store(true, std::memory_order_release);
+    }
+    finishedThumbnails = getCount();
+
+    return true;
+  }
+
+  void ThumbnailGenerator::save() const
+  {
+    if (!fileKey)
+    {
+      return;
+    }
+
+    const auto thumbnailFile = IndexCache::getCachePath(*fileKey, ".thumbs");
+
+    std::error_code error;
+    std::filesystem::create_directories(thumbnailFile.parent_path(), error);
+
+    ThumbnailFileHeader header {
+      .magic = {},
+      .version = thumbnailVersion,
+      .videoStreamIndex = videoStreamIndex,
+      .key = *fileKey,
+      .width = width,
+      .height = height,
+      .count = thumbnailFrames.size()
+    };
+    std::memcpy(header.magic, thumbnailMagic, sizeof(thumbnailMagic));
+
+    // Write next to the target and rename, so a reader never maps a partially written file
+    const auto tempFile = IndexCache::getTempPath(thumbnailFile);
+
+    {
+      std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+      if (!file.is_open())
+      {
+        return;
+      }
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(thumbnailFrames.data()),
+                 static_cast<std::streamsize>(thumbnailFrames.size() * sizeof(KeyFrameEntry)));
+      file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+
+      if (!file)
+      {
+        file.close();
+        std::filesystem::remove(tempFile, error);
+        return;
+      }
+    }
+
+    std::filesystem::rename(tempFile, thumbnailFile, error);
+    if (error)
+    {
+      std::filesystem::remove(tempFile, error);
+    }
+  }
+} // AVParser
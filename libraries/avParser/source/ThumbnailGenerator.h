@@ -0,0 +1,89 @@
+#ifndef THUMBNAILGENERATOR_H
+#define THUMBNAILGENERATOR_H
+
+#include "DecodeScheduler.h"
+#include "IndexCache.h"
+#include "PacketIndex.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace AVParser {
+
+class KeyFrameDecoder;
+
+// RGBA thumbnails of keyframes spread over the whole file, for the timeline. They are decoded one at a time on the
+// shared DecodeScheduler at thumbnail priority after the file is opened, and saved next to the packet index, so
+// reopening the file loads them instantly
+class ThumbnailGenerator {
+public:
+  // fileKey identifies the file in the thumbnail cache, without it the thumbnails are always decoded. workerCount
+  // thumbnails are decoded in parallel at most
+  ThumbnailGenerator(const std::string& mediaFile, int videoStreamIndex, int frameWidth, int frameHeight,
+                     std::span<const KeyFrameEntry> keyFrames, const std::optional<IndexCache::MediaFileKey>& fileKey,
+                     uint32_t workerCount);
+
+  ~ThumbnailGenerator();
+
+  ThumbnailGenerator(const ThumbnailGenerator&) = delete;
+  ThumbnailGenerator& operator=(const ThumbnailGenerator&) = delete;
+
+  [[nodiscard]] uint32_t getCount() const;
+
+  [[nodiscard]] int getWidth() const;
+
+  [[nodiscard]] int getHeight() const;
+
+  // Frame shown by the thumbnail
+  [[nodiscard]] uint32_t getFrame(uint32_t thumbnail) const;
+
+  // Last thumbnail at or before the frame
+  [[nodiscard]] uint32_t findThumbnail(uint32_t frame) const;
+
+  // getWidth * getHeight RGBA pixels, nullptr until the thumbnail is decoded
+  [[nodiscard]] const uint8_t* getPixels(uint32_t thumbnail) const;
+
+  [[nodiscard]] bool isComplete() const;
+
+private:
+  std::string mediaFile;
+  int videoStreamIndex;
+
+  std::optional<IndexCache::MediaFileKey> fileKey;
+
+  int width = 0;
+  int height = 0;
+
+  std::vector<KeyFrameEntry> thumbnailFrames;
+  std::vector<uint8_t> pixels;
+
+  // Set once a thumbnail's pixels are written, with release so readers see them
+  std::unique_ptr<std::atomic<bool>[]> ready;
+
+  std::atomic<uint32_t> nextThumbnail = 0;
+  std::atomic<uint32_t> finishedThumbnails = 0;
+  std::atomic<bool> stopping = false;
+
+  DecodeScheduler& scheduler;
+
+  // Decoders no task is using, opened by the first tasks and kept for the ones after them
+  std::mutex decoderMutex;
+  std::vector<std::unique_ptr<KeyFrameDecoder>> idleDecoders;
+
+  [[nodiscard]] size_t getThumbnailBytes() const;
+
+  // Decodes the next thumbnail nobody has started on, then submits itself again until none are left
+  void decodeNext();
+
+  [[nodiscard]] bool load();
+
+  void save() const;
+};
+
+} // AVParser
+
+#endif //THUMBNAILGENERATOR_H
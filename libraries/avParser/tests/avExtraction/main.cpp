@@ -84,6 +84,22 @@ void displayControls(AVParser::MediaParser& parser)
       {
         parser.play();
       }
+      ImGui::SameLine();
+      if (ImGui::Button("Reverse"))
+      {
+        parser.playReverse();
+      }
+      break;
+    case AVParser::MediaState::REVERSE_PLAYING:
+      if (ImGui::Button("Play"))
+      {
+        parser.play();
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Pause"))
+      {
+        parser.pause();
+      }
       break;
     case AVParser::MediaState::MANUAL:
       if (ImGui::Button("AUTOMATIC"))
@@ -0,0 +1,120 @@
+#include <GopDecoder.h>
+#include <PacketIndex.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct BenchmarkCase {
+  const char* name;
+  AVParser::DecoderParams params;
+};
+
+int findStream(const AVFormatContext* formatContext, const AVMediaType type)
+{
+  for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+  {
+    if (formatContext->streams[i]->codecpar->codec_type == type)
+    {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+void indexFile(const std::string& mediaFile, AVParser::PacketIndex& packetIndex, int& videoStreamIndex)
+{
+  AVFormatContext* formatContext = nullptr;
+  if (avformat_open_input(&formatContext, mediaFile.c_str(), nullptr, nullptr) < 0 ||
+      avformat_find_stream_info(formatContext, nullptr) < 0)
+  {
+    avformat_close_input(&formatContext);
+    throw std::runtime_error("Failed to open video file!");
+  }
+
+  videoStreamIndex = findStream(formatContext, AVMEDIA_TYPE_VIDEO);
+  const int audioStreamIndex = findStream(formatContext, AVMEDIA_TYPE_AUDIO);
+
+  if (videoStreamIndex == -1 || audioStreamIndex == -1)
+  {
+    avformat_close_input(&formatContext);
+    throw std::runtime_error("File needs a video and an audio stream!");
+  }
+
+  packetIndex.build(formatContext, videoStreamIndex, audioStreamIndex);
+
+  avformat_close_input(&formatContext);
+}
+
+// Decodes every GOP of the file on one decoder and returns the frames per second
+double benchmark(const std::string& mediaFile, const int videoStreamIndex, const AVParser::PacketIndex& packetIndex,
+                 const AVParser::DecoderParams& params)
+{
+  const int threadCount = params.threadsPerDecoder > 0 ? params.threadsPerDecoder : 0;
+  AVParser::FrameBufferPool framePool;
+  AVParser::GopDecoder decoder(mediaFile, videoStreamIndex, params, threadCount, framePool);
+
+  const auto keyFrames = packetIndex.getKeyFrames();
+  size_t decodedFrames = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < keyFrames.size(); i++)
+  {
+    const uint32_t gopEnd = i + 1 < keyFrames.size() ? keyFrames[i + 1].frame : packetIndex.getVideoFrameCount();
+
+    decodedFrames += decoder.decode(keyFrames[i].pts, gopEnd - keyFrames[i].frame).size();
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  return static_cast<double>(decodedFrames) / elapsed.count();
+}
+
+int main(const int argc, char* argv[])
+{
+  try
+  {
+    std::vector<std::string> mediaFiles(argv + 1, argv + argc);
+    if (mediaFiles.empty())
+    {
+      mediaFiles.emplace_back("assets/sample_720.mp4");
+    }
+
+    const int cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+
+    const std::vector<BenchmarkCase> cases {
+      { "Single thread", { .threadsPerDecoder = 1 } },
+      { "Frame threads", { .threadsPerDecoder = cores, .threadingMode = AVParser::ThreadingMode::FRAME } },
+      { "Slice threads", { .threadsPerDecoder = cores, .threadingMode = AVParser::ThreadingMode::SLICE } },
+      { "Auto threads", { .threadingMode = AVParser::ThreadingMode::AUTO } },
+      { "Auto, skip loop filter", { .skipLoopFilter = AVDISCARD_ALL } },
+      { "Auto, skip non-ref frames", { .skipLoopFilter = AVDISCARD_ALL, .skipFrame = AVDISCARD_NONREF } }
+    };
+
+    for (const auto& mediaFile : mediaFiles)
+    {
+      AVParser::PacketIndex packetIndex;
+      int videoStreamIndex = -1;
+      indexFile(mediaFile, packetIndex, videoStreamIndex);
+
+      std::cout << mediaFile << " (" << packetIndex.getVideoFrameCount() << " frames, "
+                << packetIndex.getKeyFrames().size() << " GOPs)" << std::endl;
+
+      for (const auto& [name, params] : cases)
+      {
+        std::cout << "  " << name << ": " << benchmark(mediaFile, videoStreamIndex, packetIndex, params)
+                  << " fps" << std::endl;
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+#include <AVParser.h>
+#include <IndexCache.h>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+constexpr AVParser::AudioParams audioParams;
+
+double timeOpen(const std::string& mediaFile)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto parser = AVParser::MediaParser(mediaFile, audioParams);
+
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "  Total Frames: " << parser.getTotalFrames() << std::endl;
+
+  return elapsed.count();
+}
+
+// Time until the constructor returns with the first frame, and until the background index is complete
+std::pair<double, double> timeProgressiveOpen(const std::string& mediaFile)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto parser = AVParser::MediaParser(mediaFile, audioParams, {}, AVParser::OpenMode::PROGRESSIVE);
+
+  const std::chrono::duration<double, std::milli> firstFrame = std::chrono::steady_clock::now() - start;
+
+  std::cout << "  Indexed Frames: " << parser.getIndexedFrames() << " of about " << parser.getTotalFrames()
+            << std::endl;
+
+  while (!parser.isIndexComplete())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const std::chrono::duration<double, std::milli> indexed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "  Total Frames: " << parser.getTotalFrames() << std::endl;
+
+  return { firstFrame.count(), indexed.count() };
+}
+
+int main(const int argc, char* argv[])
+{
+  try
+  {
+    const std::string mediaFile = argc == 2 ? argv[1] : "assets/sample_720.mp4";
+
+    const auto key = AVParser::IndexCache::getMediaFileKey(mediaFile);
+    const auto indexFile = AVParser::IndexCache::getCachePath(key, ".idx");
+
+    // Make sure the first open has to scan the whole file
+    std::filesystem::remove(indexFile);
+
+    std::cout << "Cold open (no index):" << std::endl;
+    const double coldTime = timeOpen(mediaFile);
+    std::cout << "  Time: " << coldTime << " ms" << std::endl;
+
+    if (!std::filesystem::exists(indexFile))
+    {
+      std::cerr << "Index was not written to " << indexFile << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Index: " << indexFile << " (" << std::filesystem::file_size(indexFile) << " bytes)" << std::endl;
+
+    std::cout << "Warm open (cached index):" << std::endl;
+    const double warmTime = timeOpen(mediaFile);
+    std::cout << "  Time: " << warmTime << " ms" << std::endl;
+
+    std::cout << "Speedup: " << coldTime / warmTime << "x" << std::endl;
+
+    // Without the cached index again, but only the first GOP is indexed before the first frame is shown
+    std::filesystem::remove(indexFile);
+
+    std::cout << "Progressive open (no index):" << std::endl;
+    const auto [firstFrameTime, indexTime] = timeProgressiveOpen(mediaFile);
+    std::cout << "  First frame: " << firstFrameTime << " ms" << std::endl;
+    std::cout << "  Index complete: " << indexTime << " ms" << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include <AVParser.h>
+#include <ReadPrefetcher.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+constexpr AVParser::AudioParams audioParams;
+
+// Evicts the file from the page cache so every run starts from the disk, best effort and not on Windows
+void dropPageCache(const std::string& mediaFile)
+{
+#ifndef _WIN32
+  const int fileDescriptor = open(mediaFile.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+  {
+    return;
+  }
+
+  fdatasync(fileDescriptor);
+  posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED);
+  close(fileDescriptor);
+#endif
+}
+
+void playWith(const std::string& mediaFile, const AVParser::ReadBackend backend, const double seconds,
+              const double rate)
+{
+  dropPageCache(mediaFile);
+
+  const AVParser::DecoderParams decoderParams{ .readBackend = backend };
+  auto parser = AVParser::MediaParser(mediaFile, audioParams, decoderParams);
+
+  parser.setPlaybackRate(rate);
+  parser.play();
+
+  const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+  while (std::chrono::steady_clock::now() < end)
+  {
+    parser.update();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  const auto playbackStats = parser.getPlaybackStats();
+  const auto cacheStats = parser.getCacheStats();
+
+  std::cout << "  Dropped Frames: " << playbackStats.droppedFrames << std::endl;
+  std::cout << "  Late Frames: " << playbackStats.lateFrames << std::endl;
+  std::cout << "  Cache Misses: " << cacheStats.misses << " of " << cacheStats.hits + cacheStats.misses << std::endl;
+}
+
+int main(const int argc, char* argv[])
+{
+  try
+  {
+    const std::string mediaFile = argc >= 2 ? argv[1] : "assets/sample_720.mp4";
+    const double seconds = argc >= 3 ? std::stod(argv[2]) : 10.0;
+    const double rate = argc >= 4 ? std::stod(argv[3]) : 1.0;
+
+    // Build the index up front so every run only measures playback
+    {
+      const auto parser = AVParser::MediaParser(mediaFile, audioParams);
+      std::cout << "Total Frames: " << parser.getTotalFrames() << std::endl;
+    }
+
+    std::cout << "No read-ahead:" << std::endl;
+    playWith(mediaFile, AVParser::ReadBackend::NONE, seconds, rate);
+
+    std::cout << "pread read-ahead:" << std::endl;
+    playWith(mediaFile, AVParser::ReadBackend::PREAD, seconds, rate);
+
+    if (AVParser::ReadPrefetcher::isIoUringAvailable())
+    {
+      std::cout << "io_uring read-ahead:" << std::endl;
+      playWith(mediaFile, AVParser::ReadBackend::IO_URING, seconds, rate);
+    }
+    else
+    {
+      std::cout << "io_uring read-ahead: not available (built without AVPARSER_IO_URING or disabled by the kernel)"
+                << std::endl;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
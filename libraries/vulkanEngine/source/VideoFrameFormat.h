@@ -0,0 +1,26 @@
+#ifndef VIDEOFRAMEFORMAT_H
+#define VIDEOFRAMEFORMAT_H
+
+namespace VkEngine {
+
+enum class VideoFormat {
+  RGBA, // 4 bytes per pixel
+  NV12  // Full size Y plane followed by an interleaved half size UV plane
+};
+
+enum class ColorMatrix {
+  BT601,
+  BT709,
+  BT2020
+};
+
+// Describes the layout of the frame data passed to loadVideoFrame, the colour fields are only used for YUV formats
+struct VideoFrameFormat {
+  VideoFormat format = VideoFormat::RGBA;
+  ColorMatrix colorMatrix = ColorMatrix::BT709;
+  bool fullRange = false;
+};
+
+} // VkEngine
+
+#endif //VIDEOFRAMEFORMAT_H
@@ -7,6 +7,7 @@
 #include "components/SwapChain.h"
 #include "components/Framebuffer.h"
 #include "components/ImGuiInstance.h"
+#include "components/ThumbnailAtlas.h"
 #include "pipelines/RenderPass.h"
 #include "pipelines/custom/GuiPipeline.h"
 #include "pipelines/custom/VideoPipeline.h"
@@ -27,6 +28,14 @@ namespace VkEngine {
 
   constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
+  // Start of each staging slot and plane, covers optimalBufferCopyOffsetAlignment on common GPUs
+  constexpr VkDeviceSize STAGING_ALIGNMENT = 256;
+
+  constexpr VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
   VulkanEngine::VulkanEngine(const VulkanEngineOptions& vulkanEngineOptions)
     : vulkanEngineOptions(vulkanEngineOptions), currentFrame(0), framebufferResized(false)
   {
@@ -43,11 +52,14 @@ namespace VkEngine {
   {
     logicalDevice->waitIdle();
 
+    thumbnailAtlas.reset();
+
     destroyVideoTexture();
 
     destroyVideoTextureSampler();
 
     vkDestroyCommandPool(logicalDevice->getDevice(), commandPool, nullptr);
+    vkDestroyCommandPool(logicalDevice->getDevice(), transferCommandPool, nullptr);
 
     glfwTerminate();
   }
@@ -76,11 +88,20 @@ namespace VkEngine {
     return ImGui::GetCurrentContext();
   }
 
-  void VulkanEngine::loadVideoFrame(std::shared_ptr<std::vector<uint8_t>> frameData, const int width, const int height)
+  void VulkanEngine::loadVideoFrame(std::shared_ptr<std::vector<uint8_t>> frameData, const int width, const int height,
+                                    const VideoFrameFormat& frameFormat)
   {
+    if (frameData != videoFrameData)
+    {
+      videoFrameGeneration++;
+    }
+
     videoFrameData = std::move(frameData);
 
-    if (videoExtent.width != width || videoExtent.height != height)
+    const bool formatChanged = videoFrameFormat.format != frameFormat.format;
+    videoFrameFormat = frameFormat;
+
+    if (videoExtent.width != width || videoExtent.height != height || formatChanged)
     {
       videoExtent.width = width;
       videoExtent.height = height;
@@ -95,6 +116,44 @@ namespace VkEngine {
     captionText = caption;
   }
 
+  VkExtent2D VulkanEngine::getVideoViewportExtent() const
+  {
+    return videoViewportExtent;
+  }
+
+  void VulkanEngine::createThumbnailAtlas(const uint32_t cellWidth, const uint32_t cellHeight,
+                                          const uint32_t cellCount)
+  {
+    logicalDevice->waitIdle();
+
+    thumbnailAtlas.reset();
+    thumbnailAtlas = std::make_unique<ThumbnailAtlas>(physicalDevice, logicalDevice, commandPool, videoTextureSampler,
+                                                      cellWidth, cellHeight, cellCount);
+  }
+
+  void VulkanEngine::loadThumbnail(const uint32_t cell, const uint8_t* pixels)
+  {
+    if (thumbnailAtlas)
+    {
+      thumbnailAtlas->loadCell(cell, pixels);
+    }
+  }
+
+  ThumbnailImage VulkanEngine::getThumbnail(const uint32_t cell) const
+  {
+    if (!thumbnailAtlas || !thumbnailAtlas->isLoaded(cell))
+    {
+      return {};
+    }
+
+    ThumbnailImage thumbnail {
+      .texture = reinterpret_cast<ImTextureID>(thumbnailAtlas->getDescriptorSet())
+    };
+    thumbnailAtlas->getCellUvs(cell, thumbnail.uv0.x, thumbnail.uv0.y, thumbnail.uv1.x, thumbnail.uv1.y);
+
+    return thumbnail;
+  }
+
   void VulkanEngine::setGrayscale(const bool useGrayscale)
   {
     grayscale = useGrayscale;
@@ -116,9 +175,12 @@ namespace VkEngine {
 
     logicalDevice = std::make_shared<LogicalDevice>(physicalDevice);
 
-    createCommandPool();
-    allocateCommandBuffers(swapchainCommandBuffers);
-    allocateCommandBuffers(videoCommandBuffers);
+    createCommandPool(logicalDevice->getGraphicsFamily(), commandPool);
+    allocateCommandBuffers(commandPool, swapchainCommandBuffers);
+    allocateCommandBuffers(commandPool, videoCommandBuffers);
+
+    createCommandPool(logicalDevice->getTransferFamily(), transferCommandPool);
+    allocateCommandBuffers(transferCommandPool, transferCommandBuffers);
 
     swapChain = std::make_shared<SwapChain>(physicalDevice, logicalDevice, window);
 
@@ -132,8 +194,8 @@ namespace VkEngine {
     guiPipeline = std::make_shared<GuiPipeline>(physicalDevice, logicalDevice, renderPass, MAX_GUI_TEXTURES);
 
 
-    imGuiInstance = std::make_shared<ImGuiInstance>(commandPool, window, instance, physicalDevice, logicalDevice,
-                                                    renderPass, guiPipeline, true);
+    imGuiInstance = std::make_shared<ImGuiInstance>(window, instance, physicalDevice, logicalDevice, renderPass,
+                                                    guiPipeline, true);
 
     videoRenderPass = std::make_shared<RenderPass>(logicalDevice, physicalDevice, VK_FORMAT_R8G8B8A8_UNORM,
                                                    physicalDevice->getMsaaSamples(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -144,29 +206,27 @@ namespace VkEngine {
     videoPipeline = std::make_unique<VideoPipeline>(physicalDevice, logicalDevice, videoRenderPass);
   }
 
-  void VulkanEngine::createCommandPool()
+  void VulkanEngine::createCommandPool(const uint32_t queueFamily, VkCommandPool& pool) const
   {
-    const auto queueFamilyIndices = physicalDevice->getQueueFamilies();
-
     const VkCommandPoolCreateInfo poolInfo {
       .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
       .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-      .queueFamilyIndex = queueFamilyIndices.graphicsFamily.value()
+      .queueFamilyIndex = queueFamily
     };
 
-    if (vkCreateCommandPool(logicalDevice->getDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    if (vkCreateCommandPool(logicalDevice->getDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to create command pool!");
     }
   }
 
-  void VulkanEngine::allocateCommandBuffers(std::vector<VkCommandBuffer>& commandBuffers) const
+  void VulkanEngine::allocateCommandBuffers(const VkCommandPool pool, std::vector<VkCommandBuffer>& commandBuffers) const
   {
     commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
 
     const VkCommandBufferAllocateInfo allocInfo {
       .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-      .commandPool = commandPool,
+      .commandPool = pool,
       .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
       .commandBufferCount = static_cast<uint32_t>(commandBuffers.size())
     };
@@ -202,6 +262,12 @@ namespace VkEngine {
     recordCommandBuffer(commandBuffer, imageIndex, [this](const VkCommandBuffer& cmdBuffer,
                         const uint32_t imgIndex)
     {
+      // Thumbnails loaded this frame are drawn by this render pass, copies can't be recorded inside it
+      if (thumbnailAtlas)
+      {
+        thumbnailAtlas->recordUploads(cmdBuffer);
+      }
+
       renderPass->begin(framebuffer->getFramebuffer(imgIndex), swapChain->getExtent(), cmdBuffer);
 
       guiPipeline->render(cmdBuffer, swapChain->getExtent());
@@ -210,8 +276,10 @@ namespace VkEngine {
     });
   }
 
-  void VulkanEngine::recordVideoCommandBuffer(const VkCommandBuffer& commandBuffer, const uint32_t imageIndex) const
+  void VulkanEngine::recordVideoCommandBuffer(const VkCommandBuffer& commandBuffer, const uint32_t imageIndex)
   {
+    videoTransferValue = 0;
+
     recordCommandBuffer(commandBuffer, imageIndex, [this](const VkCommandBuffer& cmdBuffer,
                         const uint32_t imgIndex)
     {
@@ -220,16 +288,18 @@ namespace VkEngine {
         return;
       }
 
-      if (videoFrameData)
+      // Reuse the resident texture unless a new frame arrived since it was last filled
+      if (videoFrameData && videoTextureGenerations[currentFrame] != videoFrameGeneration)
       {
-        loadVideoFrameToImage(static_cast<int>(imgIndex));
+        uploadVideoFrame(cmdBuffer);
       }
 
       videoRenderPass->begin(videoFramebuffer->getFramebuffer(imgIndex), videoViewportExtent, cmdBuffer);
 
       const auto imageAspectRatio = static_cast<float>(videoExtent.width) / static_cast<float>(videoExtent.height);
-      videoPipeline->render(cmdBuffer, videoViewportExtent, &videoTextureImageInfos[currentFrame], currentFrame,
-                            imageAspectRatio, grayscale);
+      videoPipeline->render(cmdBuffer, videoViewportExtent, &videoTextureImageInfos[currentFrame],
+                            &videoChromaImageInfos[currentFrame], currentFrame, imageAspectRatio, grayscale,
+                            videoFrameFormat);
 
       RenderPass::end(cmdBuffer);
     });
@@ -260,7 +330,7 @@ namespace VkEngine {
 
     vkResetCommandBuffer(videoCommandBuffers[currentFrame], 0);
     recordVideoCommandBuffer(videoCommandBuffers[currentFrame], imageIndex);
-    logicalDevice->submitVideoGraphicsQueue(currentFrame, &videoCommandBuffers[currentFrame]);
+    logicalDevice->submitVideoGraphicsQueue(currentFrame, &videoCommandBuffers[currentFrame], videoTransferValue);
 
     vkResetCommandBuffer(swapchainCommandBuffers[currentFrame], 0);
     recordSwapchainCommandBuffer(swapchainCommandBuffers[currentFrame], imageIndex);
@@ -405,87 +475,185 @@ namespace VkEngine {
     return true;
   }
 
-  void VulkanEngine::loadVideoFrameToImage(const int imageIndex) const
+  void VulkanEngine::uploadVideoFrame(const VkCommandBuffer& commandBuffer)
   {
-    const VkDeviceSize imageSize = videoExtent.width * videoExtent.height * 4; // RGBA format
+    if (!logicalDevice->hasAsyncTransfer())
+    {
+      loadVideoFrameToImage(commandBuffer, commandBuffer, currentFrame);
+      return;
+    }
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    Buffers::createBuffer(logicalDevice, physicalDevice, imageSize,
-                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                          stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(logicalDevice->getDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, videoFrameData->data(), imageSize);
-    vkUnmapMemory(logicalDevice->getDevice(), stagingBufferMemory);
-
-    Images::transitionImageLayout(logicalDevice, commandPool, videoTextureImages[imageIndex],
-                                  VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED,
-                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
-
-    const VkCommandBuffer commandBuffer = Buffers::beginSingleTimeCommands(logicalDevice, commandPool);
-
-    const VkBufferImageCopy region {
-      .bufferOffset = 0,
-      .bufferRowLength = 0,
-      .bufferImageHeight = 0,
-      .imageSubresource = {
-        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel = 0,
-        .baseArrayLayer = 0,
-        .layerCount = 1
-      },
-      .imageOffset = {0, 0, 0},
-      .imageExtent = {videoExtent.width, videoExtent.height, 1}
+    // The video fence of this frame covers its previous transfer, so the transfer command buffer is free again
+    const VkCommandBuffer transferCommandBuffer = transferCommandBuffers[currentFrame];
+    vkResetCommandBuffer(transferCommandBuffer, 0);
+
+    recordCommandBuffer(transferCommandBuffer, 0, [this, &commandBuffer](const VkCommandBuffer& cmdBuffer, uint32_t)
+    {
+      loadVideoFrameToImage(cmdBuffer, commandBuffer, currentFrame);
+    });
+
+    videoTransferValue = logicalDevice->submitTransferQueue(&transferCommandBuffer);
+  }
+
+  void VulkanEngine::loadVideoFrameToImage(const VkCommandBuffer& transferCommandBuffer,
+                                           const VkCommandBuffer& graphicsCommandBuffer, const uint32_t frameIndex)
+  {
+    const bool nv12 = videoFrameFormat.format == VideoFormat::NV12;
+
+    const VkExtent2D chromaExtent = getVideoChromaExtent();
+
+    // NV12 is a Y plane followed by the UV plane, RGBA is a single plane
+    const VkDeviceSize lumaSize = videoExtent.width * videoExtent.height * (nv12 ? 1 : 4);
+    const VkDeviceSize chromaSize = nv12 ? chromaExtent.width * chromaExtent.height * 2 : 0;
+
+    if (videoFrameData->size() < lumaSize + chromaSize)
+    {
+      return;
+    }
+
+    // The fence of this frame was waited on, so the GPU is done with its staging slot and texture
+    const VkDeviceSize slotOffset = frameIndex * videoStagingSlotSize;
+    memcpy(videoStagingData + slotOffset, videoFrameData->data(), lumaSize);
+
+    if (nv12)
+    {
+      memcpy(videoStagingData + slotOffset + getVideoChromaOffset(), videoFrameData->data() + lumaSize, chromaSize);
+    }
+
+    const auto copyPlane = [&](const VkImage image, const VkFormat format, const VkDeviceSize offset,
+                               const VkExtent2D extent) {
+      Images::recordTransitionImageLayout(transferCommandBuffer, image, format, VK_IMAGE_LAYOUT_UNDEFINED,
+                                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
+
+      const VkBufferImageCopy region {
+        .bufferOffset = slotOffset + offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .mipLevel = 0,
+          .baseArrayLayer = 0,
+          .layerCount = 1
+        },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {extent.width, extent.height, 1}
+      };
+
+      vkCmdCopyBufferToImage(transferCommandBuffer, videoStagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                             &region);
+
+      // A transfer only queue can't wait on the fragment shader stage, so this half runs on the graphics queue
+      Images::recordTransitionImageLayout(graphicsCommandBuffer, image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
     };
 
-    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, videoTextureImages[imageIndex],
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    copyPlane(videoTextureImages[frameIndex], getVideoLumaFormat(), 0, videoExtent);
+
+    if (nv12)
+    {
+      copyPlane(videoChromaImages[frameIndex], VK_FORMAT_R8G8_UNORM, getVideoChromaOffset(), chromaExtent);
+    }
+
+    videoTextureGenerations[frameIndex] = videoFrameGeneration;
+  }
 
-    Buffers::endSingleTimeCommands(logicalDevice, commandPool, logicalDevice->getGraphicsQueue(), commandBuffer);
+  VkDeviceSize VulkanEngine::getVideoChromaOffset() const
+  {
+    return alignUp(static_cast<VkDeviceSize>(videoExtent.width) * videoExtent.height, STAGING_ALIGNMENT);
+  }
 
-    Images::transitionImageLayout(logicalDevice, commandPool, videoTextureImages[imageIndex],
-                                  VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+  VkFormat VulkanEngine::getVideoLumaFormat() const
+  {
+    return videoFrameFormat.format == VideoFormat::NV12 ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+  }
 
-    vkDestroyBuffer(logicalDevice->getDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice->getDevice(), stagingBufferMemory, nullptr);
+  VkExtent2D VulkanEngine::getVideoChromaExtent() const
+  {
+    return { (videoExtent.width + 1) / 2, (videoExtent.height + 1) / 2 };
   }
 
   void VulkanEngine::setupVideoTexture()
   {
-    // Create Image
-    constexpr size_t numImages = 3;
+    // Create Image, one per frame in flight so a frame never overwrites a texture the GPU may still sample
+    constexpr size_t numImages = MAX_FRAMES_IN_FLIGHT;
     videoTextureImageMemory.resize(numImages);
     videoTextureImageViews.resize(numImages);
     videoTextureImages.resize(numImages);
     videoTextureImageInfos.resize(numImages);
 
-    constexpr auto imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    const bool nv12 = videoFrameFormat.format == VideoFormat::NV12;
+    videoChromaImageMemory.assign(nv12 ? numImages : 0, VK_NULL_HANDLE);
+    videoChromaImageViews.assign(nv12 ? numImages : 0, VK_NULL_HANDLE);
+    videoChromaImages.assign(nv12 ? numImages : 0, VK_NULL_HANDLE);
+    videoChromaImageInfos.resize(numImages);
 
-    for (int i = 0; i < numImages; i++)
+    // New textures hold no frame yet
+    videoTextureGenerations.assign(numImages, 0);
+
+    // Written by the transfer queue and sampled by the graphics queue
+    std::vector<uint32_t> sharingQueueFamilies;
+    if (logicalDevice->getTransferFamily() != logicalDevice->getGraphicsFamily())
     {
-      Images::createImage(logicalDevice, physicalDevice, videoExtent.width, videoExtent.height, 1,
-                          1, VK_SAMPLE_COUNT_1_BIT, imageFormat, VK_IMAGE_TILING_OPTIMAL,
+      sharingQueueFamilies = { logicalDevice->getGraphicsFamily(), logicalDevice->getTransferFamily() };
+    }
+
+    // Every plane starts in shader read layout, transitioned in a single submission
+    const VkCommandBuffer setupCommandBuffer = Buffers::beginSingleTimeCommands(logicalDevice, commandPool);
+
+    const auto createPlane = [&](const VkExtent2D extent, const VkFormat format, VkImage& image,
+                                 VkDeviceMemory& imageMemory, VkImageView& imageView) {
+      Images::createImage(logicalDevice, physicalDevice, extent.width, extent.height, 1,
+                          1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, videoTextureImages[i],
-                          videoTextureImageMemory[i], VK_IMAGE_TYPE_2D);
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory, VK_IMAGE_TYPE_2D,
+                          sharingQueueFamilies);
+
+      imageView = Images::createImageView(logicalDevice, image, format, VK_IMAGE_ASPECT_COLOR_BIT, 1,
+                                          VK_IMAGE_VIEW_TYPE_2D);
 
-      videoTextureImageViews[i] = Images::createImageView(logicalDevice, videoTextureImages[i],
-                                                         imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_VIEW_TYPE_2D);
+      Images::recordTransitionImageLayout(setupCommandBuffer, image, format, VK_IMAGE_LAYOUT_UNDEFINED,
+                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+    };
+
+    for (int i = 0; i < numImages; i++)
+    {
+      createPlane(videoExtent, getVideoLumaFormat(), videoTextureImages[i], videoTextureImageMemory[i],
+                  videoTextureImageViews[i]);
 
-      Images::transitionImageLayout(this->logicalDevice, commandPool, videoTextureImages[i], imageFormat, VK_IMAGE_LAYOUT_UNDEFINED,
-                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+      if (nv12)
+      {
+        createPlane(getVideoChromaExtent(), VK_FORMAT_R8G8_UNORM, videoChromaImages[i], videoChromaImageMemory[i],
+                    videoChromaImageViews[i]);
+      }
     }
 
+    Buffers::endSingleTimeCommands(logicalDevice, commandPool, logicalDevice->getGraphicsQueue(), setupCommandBuffer);
+
+    // Staging ring, one slot per frame in flight
+    const VkDeviceSize frameSize = videoFrameFormat.format == VideoFormat::NV12
+      ? getVideoChromaOffset() + getVideoChromaExtent().width * getVideoChromaExtent().height * 2
+      : static_cast<VkDeviceSize>(videoExtent.width) * videoExtent.height * 4;
+    videoStagingSlotSize = alignUp(frameSize, STAGING_ALIGNMENT);
+
+    Buffers::createBuffer(logicalDevice, physicalDevice, videoStagingSlotSize * MAX_FRAMES_IN_FLIGHT,
+                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                          videoStagingBuffer, videoStagingBufferMemory);
+
+    void* stagingData;
+    vkMapMemory(logicalDevice->getDevice(), videoStagingBufferMemory, 0, VK_WHOLE_SIZE, 0, &stagingData);
+    videoStagingData = static_cast<uint8_t*>(stagingData);
+
     // Setup Image Info
-    for (int i = 0; i < videoTextureImageInfos.capacity(); i++)
+    for (int i = 0; i < videoTextureImageInfos.size(); i++)
     {
       videoTextureImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
       videoTextureImageInfos[i].imageView = videoTextureImageViews[i];
       videoTextureImageInfos[i].sampler = videoTextureSampler;
+
+      videoChromaImageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      videoChromaImageInfos[i].imageView = nv12 ? videoChromaImageViews[i] : videoTextureImageViews[i];
+      videoChromaImageInfos[i].sampler = videoTextureSampler;
     }
   }
 
@@ -493,19 +661,32 @@ namespace VkEngine {
   {
     logicalDevice->waitIdle(); // This is bad practice but works for now
 
-    for (const auto& imageView : videoTextureImageViews)
+    vkUnmapMemory(logicalDevice->getDevice(), videoStagingBufferMemory);
+    vkDestroyBuffer(logicalDevice->getDevice(), videoStagingBuffer, nullptr);
+    vkFreeMemory(logicalDevice->getDevice(), videoStagingBufferMemory, nullptr);
+
+    for (const auto& imageViews : { &videoTextureImageViews, &videoChromaImageViews })
     {
-      vkDestroyImageView(logicalDevice->getDevice(), imageView, nullptr);
+      for (const auto& imageView : *imageViews)
+      {
+        vkDestroyImageView(logicalDevice->getDevice(), imageView, nullptr);
+      }
     }
 
-    for (const auto& imageMemory : videoTextureImageMemory)
+    for (const auto& imagesMemory : { &videoTextureImageMemory, &videoChromaImageMemory })
     {
-      vkFreeMemory(logicalDevice->getDevice(), imageMemory, nullptr);
+      for (const auto& imageMemory : *imagesMemory)
+      {
+        vkFreeMemory(logicalDevice->getDevice(), imageMemory, nullptr);
+      }
     }
 
-    for (const auto& image : videoTextureImages)
+    for (const auto& images : { &videoTextureImages, &videoChromaImages })
     {
-      vkDestroyImage(logicalDevice->getDevice(), image, nullptr);
+      for (const auto& image : *images)
+      {
+        vkDestroyImage(logicalDevice->getDevice(), image, nullptr);
+      }
     }
   }
 
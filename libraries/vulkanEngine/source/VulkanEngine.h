@@ -1,6 +1,7 @@
 #ifndef VULKANENGINE_H
 #define VULKANENGINE_H
 
+#include "VideoFrameFormat.h"
 #include "VulkanEngineOptions.h"
 #include "components/Window.h"
 #include <imgui_internal.h>
@@ -21,6 +22,13 @@ class Framebuffer;
 class GuiPipeline;
 class VideoPipeline;
 class ImGuiInstance;
+class ThumbnailAtlas;
+
+struct ThumbnailImage {
+  ImTextureID texture{}; // Null until the thumbnail is uploaded
+  ImVec2 uv0;
+  ImVec2 uv1;
+};
 
 class VulkanEngine {
 public:
@@ -35,10 +43,22 @@ public:
   [[nodiscard]] bool keyIsPressed(int key) const;
   static ImGuiContext* getImGuiContext();
 
-  void loadVideoFrame(std::shared_ptr<std::vector<uint8_t>> frameData, int width, int height);
+  void loadVideoFrame(std::shared_ptr<std::vector<uint8_t>> frameData, int width, int height,
+                      const VideoFrameFormat& frameFormat = {});
 
   void loadCaption(const char* caption);
 
+  // Size in pixels the video is rendered at, decoding frames larger than this is wasted
+  [[nodiscard]] VkExtent2D getVideoViewportExtent() const;
+
+  // Replaces the thumbnails with an empty atlas of cellCount thumbnails, all drawn from a single texture
+  void createThumbnailAtlas(uint32_t cellWidth, uint32_t cellHeight, uint32_t cellCount);
+
+  // Uploads cellWidth * cellHeight RGBA pixels into the cell with the next rendered frame
+  void loadThumbnail(uint32_t cell, const uint8_t* pixels);
+
+  [[nodiscard]] ThumbnailImage getThumbnail(uint32_t cell) const;
+
   void setGrayscale(bool useGrayscale);
 
 private:
@@ -62,6 +82,10 @@ private:
   VkCommandPool commandPool = VK_NULL_HANDLE;
   std::vector<VkCommandBuffer> swapchainCommandBuffers;
 
+  // Video uploads recorded for the transfer queue, one per frame in flight
+  VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+  std::vector<VkCommandBuffer> transferCommandBuffers;
+
   std::shared_ptr<Framebuffer> framebuffer;
 
   uint32_t currentFrame;
@@ -75,6 +99,14 @@ private:
   VkExtent2D videoViewportExtent{ 100, 100 };
 
   std::shared_ptr<std::vector<uint8_t>> videoFrameData;
+  VideoFrameFormat videoFrameFormat;
+
+  // Bumped for every new frame, each texture remembers the generation it holds so unchanged frames aren't uploaded
+  uint64_t videoFrameGeneration = 0;
+  std::vector<uint64_t> videoTextureGenerations{};
+
+  // Transfer timeline value the current video submission waits on, 0 when nothing was uploaded asynchronously
+  uint64_t videoTransferValue = 0;
 
   std::vector<VkImage> videoTextureImages{};
   std::vector<VkDeviceMemory> videoTextureImageMemory{};
@@ -82,20 +114,34 @@ private:
   VkSampler videoTextureSampler = VK_NULL_HANDLE;
   std::vector<VkDescriptorImageInfo> videoTextureImageInfos{};
 
+  // Persistently mapped staging memory with one slot per frame in flight
+  VkBuffer videoStagingBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory videoStagingBufferMemory = VK_NULL_HANDLE;
+  uint8_t* videoStagingData = nullptr;
+  VkDeviceSize videoStagingSlotSize = 0;
+
+  // UV plane of NV12 frames, for RGBA frames the infos point at the RGBA images
+  std::vector<VkImage> videoChromaImages{};
+  std::vector<VkDeviceMemory> videoChromaImageMemory{};
+  std::vector<VkImageView> videoChromaImageViews{};
+  std::vector<VkDescriptorImageInfo> videoChromaImageInfos{};
+
+  std::unique_ptr<ThumbnailAtlas> thumbnailAtlas;
+
   const char* captionText = "";
 
   bool grayscale = false;
 
   void initVulkan();
-  void createCommandPool();
-  void allocateCommandBuffers(std::vector<VkCommandBuffer>& commandBuffers) const;
+  void createCommandPool(uint32_t queueFamily, VkCommandPool& pool) const;
+  void allocateCommandBuffers(VkCommandPool pool, std::vector<VkCommandBuffer>& commandBuffers) const;
 
   static void recordCommandBuffer(const VkCommandBuffer& commandBuffer, uint32_t imageIndex,
                                   const std::function<void(const VkCommandBuffer& cmdBuffer, uint32_t imgIndex)>& renderFunction);
 
   void recordSwapchainCommandBuffer(const VkCommandBuffer& commandBuffer, uint32_t imageIndex) const;
 
-  void recordVideoCommandBuffer(const VkCommandBuffer& commandBuffer, uint32_t imageIndex) const;
+  void recordVideoCommandBuffer(const VkCommandBuffer& commandBuffer, uint32_t imageIndex);
 
   void doRendering();
 
@@ -109,7 +155,17 @@ private:
 
   [[nodiscard]] bool validateVideoWidget();
 
-  void loadVideoFrameToImage(int imageIndex) const;
+  void uploadVideoFrame(const VkCommandBuffer& commandBuffer);
+
+  // Records the copy into transferCommandBuffer and the transition to shader read into graphicsCommandBuffer
+  void loadVideoFrameToImage(const VkCommandBuffer& transferCommandBuffer, const VkCommandBuffer& graphicsCommandBuffer,
+                             uint32_t frameIndex);
+
+  [[nodiscard]] VkDeviceSize getVideoChromaOffset() const;
+
+  [[nodiscard]] VkFormat getVideoLumaFormat() const;
+
+  [[nodiscard]] VkExtent2D getVideoChromaExtent() const;
 
   void setupVideoTexture();
 
@@ -5,14 +5,13 @@
 #include "../components/Window.h"
 #include "../pipelines/RenderPass.h"
 #include "../pipelines/custom/GuiPipeline.h"
-#include "../utilities/Buffers.h"
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_vulkan.h>
 
 namespace VkEngine {
-  ImGuiInstance::ImGuiInstance(const VkCommandPool& commandPool, const std::shared_ptr<Window>& window,
+  ImGuiInstance::ImGuiInstance(const std::shared_ptr<Window>& window,
                                const std::shared_ptr<Instance>& instance,
                                const std::shared_ptr<PhysicalDevice>& physicalDevice,
                                const std::shared_ptr<LogicalDevice>& logicalDevice,
@@ -54,9 +53,8 @@ namespace VkEngine {
       ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
     }
 
-    const VkCommandBuffer commandBuffer = Buffers::beginSingleTimeCommands(logicalDevice, commandPool);
+    // The backend records and submits the font upload itself, its barriers need the graphics queue
     ImGui_ImplVulkan_CreateFontsTexture();
-    Buffers::endSingleTimeCommands(logicalDevice, commandPool, logicalDevice->getGraphicsQueue(), commandBuffer);
 
     createNewFrame();
   }
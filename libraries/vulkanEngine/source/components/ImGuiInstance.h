@@ -16,10 +16,10 @@ class GuiPipeline;
 
 class ImGuiInstance {
 public:
-  ImGuiInstance(const VkCommandPool& commandPool, const std::shared_ptr<Window>& window,
-                const std::shared_ptr<Instance>& instance, const std::shared_ptr<PhysicalDevice>& physicalDevice,
-                const std::shared_ptr<LogicalDevice>& logicalDevice, const std::shared_ptr<RenderPass>& renderPass,
-                const std::shared_ptr<GuiPipeline>& guiPipeline, bool useDockSpace);
+  ImGuiInstance(const std::shared_ptr<Window>& window, const std::shared_ptr<Instance>& instance,
+                const std::shared_ptr<PhysicalDevice>& physicalDevice, const std::shared_ptr<LogicalDevice>& logicalDevice,
+                const std::shared_ptr<RenderPass>& renderPass, const std::shared_ptr<GuiPipeline>& guiPipeline,
+                bool useDockSpace);
   ~ImGuiInstance();
 
   void createNewFrame();
@@ -30,7 +30,7 @@ namespace VkEngine {
       .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
       .pEngineName = "No Engine",
       .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-      .apiVersion = VK_API_VERSION_1_1
+      .apiVersion = VK_API_VERSION_1_2
     };
 
     const auto extensions = getRequiredExtensions();
@@ -48,6 +48,26 @@ namespace VkEngine {
     return presentQueue;
   }
 
+  VkQueue LogicalDevice::getTransferQueue() const
+  {
+    return transferQueue;
+  }
+
+  uint32_t LogicalDevice::getGraphicsFamily() const
+  {
+    return graphicsFamily;
+  }
+
+  uint32_t LogicalDevice::getTransferFamily() const
+  {
+    return transferFamily;
+  }
+
+  bool LogicalDevice::hasAsyncTransfer() const
+  {
+    return asyncTransfer;
+  }
+
   void LogicalDevice::submitGraphicsQueue(const uint32_t currentFrame, const VkCommandBuffer* commandBuffer) const
   {
     const std::array waitSemaphores = {
@@ -75,17 +95,27 @@ namespace VkEngine {
     }
   }
 
-  void LogicalDevice::submitVideoGraphicsQueue(const uint32_t currentFrame, const VkCommandBuffer *commandBuffer) const
+  void LogicalDevice::submitVideoGraphicsQueue(const uint32_t currentFrame, const VkCommandBuffer *commandBuffer,
+                                               const uint64_t transferValue) const
   {
+    // The upload's layout transition to shader read is the first transfer stage work in the command buffer
     constexpr VkPipelineStageFlags waitStages[] = {
-      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+      VK_PIPELINE_STAGE_TRANSFER_BIT
+    };
+
+    const VkTimelineSemaphoreSubmitInfo timelineInfo {
+      .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+      .waitSemaphoreValueCount = 1,
+      .pWaitSemaphoreValues = &transferValue
     };
 
+    const bool waitForTransfer = transferValue != 0;
+
     const VkSubmitInfo submitInfo {
       .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-      .waitSemaphoreCount = 0,
-      .pWaitSemaphores = nullptr,
+      .pNext = waitForTransfer ? &timelineInfo : nullptr,
+      .waitSemaphoreCount = waitForTransfer ? 1u : 0u,
+      .pWaitSemaphores = waitForTransfer ? &transferTimeline : nullptr,
       .pWaitDstStageMask = waitStages,
       .commandBufferCount = 1,
       .pCommandBuffers = commandBuffer,
@@ -99,6 +129,35 @@ namespace VkEngine {
     }
   }
 
+  uint64_t LogicalDevice::submitTransferQueue(const VkCommandBuffer* commandBuffer)
+  {
+    const uint64_t signalValue = transferTimelineValue + 1;
+
+    const VkTimelineSemaphoreSubmitInfo timelineInfo {
+      .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+      .signalSemaphoreValueCount = 1,
+      .pSignalSemaphoreValues = &signalValue
+    };
+
+    const VkSubmitInfo submitInfo {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .pNext = &timelineInfo,
+      .commandBufferCount = 1,
+      .pCommandBuffers = commandBuffer,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores = &transferTimeline
+    };
+
+    if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to submit transfer command buffer!");
+    }
+
+    transferTimelineValue = signalValue;
+
+    return signalValue;
+  }
+
   void LogicalDevice::waitForGraphicsFences(const uint32_t currentFrame) const
   {
     vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
@@ -141,10 +200,16 @@ namespace VkEngine {
 
   void LogicalDevice::createDevice(const std::shared_ptr<PhysicalDevice>& physicalDevice)
   {
-    auto [graphicsFamily, presentFamily] = physicalDevice->getQueueFamilies();
+    const QueueFamilyIndices indices = physicalDevice->getQueueFamilies();
+
+    // Without timeline semaphores uploads stay in the graphics command buffers
+    asyncTransfer = physicalDevice->supportsTimelineSemaphores();
+
+    graphicsFamily = indices.graphicsFamily.value();
+    transferFamily = asyncTransfer ? indices.transferFamily.value() : graphicsFamily;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set uniqueQueueFamilies = {graphicsFamily.value(), presentFamily.value()};
+    std::set uniqueQueueFamilies = {graphicsFamily, indices.presentFamily.value(), transferFamily};
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -163,8 +228,14 @@ namespace VkEngine {
       .samplerAnisotropy = VK_TRUE
     };
 
+    constexpr VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+      .timelineSemaphore = VK_TRUE
+    };
+
     const VkDeviceCreateInfo createInfo {
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = asyncTransfer ? &timelineSemaphoreFeatures : nullptr,
       .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
       .pQueueCreateInfos = queueCreateInfos.data(),
       .enabledLayerCount = enableValidationLayers ? static_cast<uint32_t>(validationLayers.size()) : 0,
@@ -179,8 +250,9 @@ namespace VkEngine {
       throw std::runtime_error("failed to create logical device!");
     }
 
-    vkGetDeviceQueue(device, graphicsFamily.value(), 0, &graphicsQueue);
-    vkGetDeviceQueue(device, presentFamily.value(), 0, &presentQueue);
+    vkGetDeviceQueue(device, graphicsFamily, 0, &graphicsQueue);
+    vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
   }
 
   void LogicalDevice::createSyncObjects()
@@ -214,6 +286,27 @@ namespace VkEngine {
         throw std::runtime_error("failed to create graphics sync objects!");
       }
     }
+
+    if (!asyncTransfer)
+    {
+      return;
+    }
+
+    constexpr VkSemaphoreTypeCreateInfo timelineTypeInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = 0
+    };
+
+    const VkSemaphoreCreateInfo timelineInfo {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timelineTypeInfo
+    };
+
+    if (vkCreateSemaphore(device, &timelineInfo, nullptr, &transferTimeline) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create transfer timeline semaphore!");
+    }
   }
 
   void LogicalDevice::destroySyncObjects() const
@@ -228,5 +321,7 @@ namespace VkEngine {
       vkDestroySemaphore(device, videoImageAvailableSemaphores[i], nullptr);
       vkDestroyFence(device, videoInFlightFences[i], nullptr);
     }
+
+    vkDestroySemaphore(device, transferTimeline, nullptr);
   }
 } // VkEngine
\ No newline at end of file
@@ -19,9 +19,22 @@ public:
 
   [[nodiscard]] VkQueue getGraphicsQueue() const;
   [[nodiscard]] VkQueue getPresentQueue() const;
+  [[nodiscard]] VkQueue getTransferQueue() const;
+
+  [[nodiscard]] uint32_t getGraphicsFamily() const;
+  [[nodiscard]] uint32_t getTransferFamily() const;
+
+  // True when uploads can be submitted to the transfer queue and waited on through the transfer timeline
+  [[nodiscard]] bool hasAsyncTransfer() const;
 
   void submitGraphicsQueue(uint32_t currentFrame, const VkCommandBuffer* commandBuffer) const;
-  void submitVideoGraphicsQueue(uint32_t currentFrame, const VkCommandBuffer* commandBuffer) const;
+
+  // Waits at the transfer stage for the transfer timeline to reach transferValue, 0 waits for nothing
+  void submitVideoGraphicsQueue(uint32_t currentFrame, const VkCommandBuffer* commandBuffer,
+                                uint64_t transferValue) const;
+
+  // Returns the timeline value signalled once the command buffer completes
+  uint64_t submitTransferQueue(const VkCommandBuffer* commandBuffer);
 
   void waitForGraphicsFences(uint32_t currentFrame) const;
   void resetGraphicsFences(uint32_t currentFrame) const;
@@ -35,6 +48,15 @@ private:
 
   VkQueue graphicsQueue = VK_NULL_HANDLE;
   VkQueue presentQueue = VK_NULL_HANDLE;
+  VkQueue transferQueue = VK_NULL_HANDLE;
+
+  uint32_t graphicsFamily = 0;
+  uint32_t transferFamily = 0;
+
+  bool asyncTransfer = false;
+
+  VkSemaphore transferTimeline = VK_NULL_HANDLE;
+  uint64_t transferTimelineValue = 0;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
@@ -13,6 +13,8 @@ namespace VkEngine {
     queueFamilyIndices = findQueueFamilies(physicalDevice);
 
     swapChainSupportDetails = querySwapChainSupport(physicalDevice);
+
+    timelineSemaphores = checkTimelineSemaphoreSupport();
   }
 
   VkPhysicalDevice PhysicalDevice::getPhysicalDevice() const
@@ -35,6 +37,11 @@ namespace VkEngine {
     return msaaSamples;
   }
 
+  bool PhysicalDevice::supportsTimelineSemaphores() const
+  {
+    return timelineSemaphores;
+  }
+
   uint32_t PhysicalDevice::findMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags properties) const
   {
     VkPhysicalDeviceMemoryProperties memoryProperties;
@@ -111,30 +118,48 @@ namespace VkEngine {
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+    std::optional<uint32_t> computeTransferFamily;
+
     int i = 0;
     for (const auto& queueFamily : queueFamilies)
     {
-      if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+      // Prefer a transfer only family, a compute family without graphics can still copy asynchronously
+      if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
       {
-        indices.graphicsFamily = i;
+        if (!(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !indices.transferFamily.has_value())
+        {
+          indices.transferFamily = i;
+        }
+        else if (!computeTransferFamily.has_value())
+        {
+          computeTransferFamily = i;
+        }
       }
 
-      VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-
-      if (presentSupport)
+      if (!indices.isComplete())
       {
-        indices.presentFamily = i;
-      }
-
-      if (indices.isComplete())
-      {
-        break;
+        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+          indices.graphicsFamily = i;
+        }
+
+        VkBool32 presentSupport = false;
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+
+        if (presentSupport)
+        {
+          indices.presentFamily = i;
+        }
       }
 
       i++;
     }
 
+    if (!indices.transferFamily.has_value())
+    {
+      indices.transferFamily = computeTransferFamily.has_value() ? computeTransferFamily : indices.graphicsFamily;
+    }
+
     return indices;
   }
 
@@ -193,6 +218,30 @@ namespace VkEngine {
     return VK_SAMPLE_COUNT_1_BIT;
   }
 
+  bool PhysicalDevice::checkTimelineSemaphoreSupport() const
+  {
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+    if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_2)
+    {
+      return false;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES
+    };
+
+    VkPhysicalDeviceFeatures2 features {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = &timelineSemaphoreFeatures
+    };
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+  }
+
   bool PhysicalDevice::checkDeviceExtensionSupport(VkPhysicalDevice device)
   {
     uint32_t extensionCount;
@@ -21,6 +21,9 @@ struct QueueFamilyIndices {
   std::optional<uint32_t> graphicsFamily;
   std::optional<uint32_t> presentFamily;
 
+  // A family without graphics support, usually backed by a dedicated copy engine
+  std::optional<uint32_t> transferFamily;
+
   [[nodiscard]] bool isComplete() const
   {
     return graphicsFamily.has_value() && presentFamily.has_value();
@@ -45,6 +48,8 @@ public:
 
   [[nodiscard]] VkSampleCountFlagBits getMsaaSamples() const;
 
+  [[nodiscard]] bool supportsTimelineSemaphores() const;
+
   [[nodiscard]] uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 
   void updateSwapChainSupportDetails();
@@ -56,6 +61,8 @@ private:
 
   VkSampleCountFlagBits msaaSamples;
 
+  bool timelineSemaphores = false;
+
   QueueFamilyIndices queueFamilyIndices;
 
   SwapChainSupportDetails swapChainSupportDetails;
@@ -70,6 +77,8 @@ private:
 
   [[nodiscard]] VkSampleCountFlagBits getMaxUsableSampleCount() const;
 
+  [[nodiscard]] bool checkTimelineSemaphoreSupport() const;
+
   static bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 };
 
@@ -0,0 +1,149 @@
+#include "ThumbnailAtlas.h"
+#include "LogicalDevice.h"
+#include "PhysicalDevice.h"
+#include "../utilities/Buffers.h"
+#include "../utilities/Images.h"
+#include <backends/imgui_impl_vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace VkEngine {
+  // Every Vulkan device supports 2D images at least this wide
+  constexpr uint32_t MAX_ATLAS_WIDTH = 4096;
+
+  ThumbnailAtlas::ThumbnailAtlas(std::shared_ptr<PhysicalDevice> physicalDevice,
+                                 std::shared_ptr<LogicalDevice> logicalDevice, const VkCommandPool& commandPool,
+                                 const VkSampler sampler, const uint32_t cellWidth, const uint32_t cellHeight,
+                                 const uint32_t cellCount)
+    : physicalDevice(std::move(physicalDevice)), logicalDevice(std::move(logicalDevice)), cellWidth(cellWidth),
+      cellHeight(cellHeight), cellCount(cellCount), loadedCells(cellCount, false)
+  {
+    if (cellWidth == 0 || cellHeight == 0 || cellCount == 0 || cellWidth > MAX_ATLAS_WIDTH)
+    {
+      throw std::invalid_argument("Invalid thumbnail atlas size!");
+    }
+
+    columns = std::min(cellCount, MAX_ATLAS_WIDTH / cellWidth);
+    rows = (cellCount + columns - 1) / columns;
+
+    Images::createImage(this->logicalDevice, this->physicalDevice, columns * cellWidth, rows * cellHeight, 1, 1,
+                        VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory, VK_IMAGE_TYPE_2D);
+
+    imageView = Images::createImageView(this->logicalDevice, image, VK_FORMAT_R8G8B8A8_UNORM,
+                                        VK_IMAGE_ASPECT_COLOR_BIT, 1, VK_IMAGE_VIEW_TYPE_2D);
+
+    // Uploads expect the atlas to be in shader read layout already
+    Images::transitionImageLayout(this->logicalDevice, commandPool, image, VK_FORMAT_R8G8B8A8_UNORM,
+                                  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+    Buffers::createBuffer(this->logicalDevice, this->physicalDevice, getCellBytes() * cellCount,
+                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                          stagingBuffer, stagingBufferMemory);
+
+    void* data;
+    vkMapMemory(this->logicalDevice->getDevice(), stagingBufferMemory, 0, VK_WHOLE_SIZE, 0, &data);
+    stagingData = static_cast<uint8_t*>(data);
+
+    descriptorSet = ImGui_ImplVulkan_AddTexture(sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  }
+
+  ThumbnailAtlas::~ThumbnailAtlas()
+  {
+    ImGui_ImplVulkan_RemoveTexture(descriptorSet);
+
+    vkUnmapMemory(logicalDevice->getDevice(), stagingBufferMemory);
+    Buffers::destroyBuffer(logicalDevice, stagingBuffer, stagingBufferMemory);
+
+    vkDestroyImageView(logicalDevice->getDevice(), imageView, nullptr);
+    vkDestroyImage(logicalDevice->getDevice(), image, nullptr);
+    vkFreeMemory(logicalDevice->getDevice(), imageMemory, nullptr);
+  }
+
+  void ThumbnailAtlas::loadCell(const uint32_t cell, const uint8_t* pixels)
+  {
+    if (cell >= cellCount || loadedCells[cell])
+    {
+      return;
+    }
+
+    memcpy(stagingData + cell * getCellBytes(), pixels, getCellBytes());
+
+    loadedCells[cell] = true;
+    pendingCells.push_back(cell);
+  }
+
+  void ThumbnailAtlas::recordUploads(const VkCommandBuffer& commandBuffer)
+  {
+    if (pendingCells.empty())
+    {
+      return;
+    }
+
+    std::vector<VkBufferImageCopy> regions;
+    regions.reserve(pendingCells.size());
+
+    for (const uint32_t cell : pendingCells)
+    {
+      regions.push_back({
+        .bufferOffset = cell * getCellBytes(),
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .mipLevel = 0,
+          .baseArrayLayer = 0,
+          .layerCount = 1
+        },
+        .imageOffset = {
+          static_cast<int32_t>(cell % columns * cellWidth),
+          static_cast<int32_t>(cell / columns * cellHeight),
+          0
+        },
+        .imageExtent = {cellWidth, cellHeight, 1}
+      });
+    }
+
+    // All new cells go in one copy, the cells that are already loaded stay as they are
+    Images::recordTransitionImageLayout(commandBuffer, image, VK_FORMAT_R8G8B8A8_UNORM,
+                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
+
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()), regions.data());
+
+    Images::recordTransitionImageLayout(commandBuffer, image, VK_FORMAT_R8G8B8A8_UNORM,
+                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+    pendingCells.clear();
+  }
+
+  bool ThumbnailAtlas::isLoaded(const uint32_t cell) const
+  {
+    return cell < cellCount && loadedCells[cell];
+  }
+
+  VkDescriptorSet ThumbnailAtlas::getDescriptorSet() const
+  {
+    return descriptorSet;
+  }
+
+  void ThumbnailAtlas::getCellUvs(const uint32_t cell, float& u0, float& v0, float& u1, float& v1) const
+  {
+    const auto atlasWidth = static_cast<float>(columns * cellWidth);
+    const auto atlasHeight = static_cast<float>(rows * cellHeight);
+
+    u0 = static_cast<float>(cell % columns * cellWidth) / atlasWidth;
+    v0 = static_cast<float>(cell / columns * cellHeight) / atlasHeight;
+    u1 = u0 + static_cast<float>(cellWidth) / atlasWidth;
+    v1 = v0 + static_cast<float>(cellHeight) / atlasHeight;
+  }
+
+  VkDeviceSize ThumbnailAtlas::getCellBytes() const
+  {
+    return static_cast<VkDeviceSize>(cellWidth) * cellHeight * 4;
+  }
+} // VkEngine
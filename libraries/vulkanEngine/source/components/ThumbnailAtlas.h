@@ -0,0 +1,65 @@
+#ifndef THUMBNAILATLAS_H
+#define THUMBNAILATLAS_H
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <vector>
+
+namespace VkEngine {
+
+class LogicalDevice;
+class PhysicalDevice;
+
+// Many small RGBA images packed in a grid of equal cells of one texture, so they take a single ImGui texture slot
+class ThumbnailAtlas {
+public:
+  ThumbnailAtlas(std::shared_ptr<PhysicalDevice> physicalDevice, std::shared_ptr<LogicalDevice> logicalDevice,
+                 const VkCommandPool& commandPool, VkSampler sampler, uint32_t cellWidth, uint32_t cellHeight,
+                 uint32_t cellCount);
+  ~ThumbnailAtlas();
+
+  ThumbnailAtlas(const ThumbnailAtlas&) = delete;
+  ThumbnailAtlas& operator=(const ThumbnailAtlas&) = delete;
+
+  // Copies cellWidth * cellHeight RGBA pixels into staging memory, they reach the texture with the next recordUploads
+  void loadCell(uint32_t cell, const uint8_t* pixels);
+
+  // Records the copies of the cells loaded since the last call, outside the render pass that samples the atlas
+  void recordUploads(const VkCommandBuffer& commandBuffer);
+
+  [[nodiscard]] bool isLoaded(uint32_t cell) const;
+
+  [[nodiscard]] VkDescriptorSet getDescriptorSet() const;
+
+  // Normalized texture coordinates of the cell's top left and bottom right corners
+  void getCellUvs(uint32_t cell, float& u0, float& v0, float& u1, float& v1) const;
+
+private:
+  std::shared_ptr<PhysicalDevice> physicalDevice;
+  std::shared_ptr<LogicalDevice> logicalDevice;
+
+  uint32_t cellWidth;
+  uint32_t cellHeight;
+  uint32_t cellCount;
+  uint32_t columns;
+  uint32_t rows;
+
+  VkImage image = VK_NULL_HANDLE;
+  VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+  VkImageView imageView = VK_NULL_HANDLE;
+  VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+  // Every cell has its own staging slot, cells are written once so a slot is never reused while a copy reads it
+  VkBuffer stagingBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+  uint8_t* stagingData = nullptr;
+
+  std::vector<bool> loadedCells;
+  std::vector<uint32_t> pendingCells;
+
+  [[nodiscard]] VkDeviceSize getCellBytes() const;
+};
+
+} // VkEngine
+
+#endif //THUMBNAILATLAS_H
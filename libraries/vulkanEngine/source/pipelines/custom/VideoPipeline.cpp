@@ -34,8 +34,9 @@ namespace VkEngine {
   }
 
   void VideoPipeline::render(const VkCommandBuffer& commandBuffer, const VkExtent2D swapChainExtent,
-                             const VkDescriptorImageInfo* imageInfo,  const uint32_t currentFrame,
-                             const float imageAspectRatio, const bool grayscale) const
+                             const VkDescriptorImageInfo* imageInfo, const VkDescriptorImageInfo* chromaImageInfo,
+                             const uint32_t currentFrame, const float imageAspectRatio, const bool grayscale,
+                             const VideoFrameFormat& frameFormat) const
   {
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
@@ -59,11 +60,14 @@ namespace VkEngine {
       .width = static_cast<float>(swapChainExtent.width),
       .height = static_cast<float>(swapChainExtent.height),
       .imageAspectRatio = imageAspectRatio,
-      .grayscale = grayscale
+      .grayscale = grayscale,
+      .videoFormat = static_cast<int>(frameFormat.format),
+      .colorMatrix = static_cast<int>(frameFormat.colorMatrix),
+      .fullRange = frameFormat.fullRange
     };
     screenSizeUniform->update(currentFrame, &screenSizeUBO, sizeof(ScreenSizeUniform));
 
-    const std::array<VkWriteDescriptorSet, 1> descriptorWrites{{
+    const std::array<VkWriteDescriptorSet, 2> descriptorWrites{{
       {
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet = descriptorSets[currentFrame],
@@ -72,6 +76,15 @@ namespace VkEngine {
         .descriptorCount = 1,
         .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
         .pImageInfo = imageInfo
+      },
+      {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptorSets[currentFrame],
+        .dstBinding = 3,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = chromaImageInfo
       }
     }};
 
@@ -111,9 +124,17 @@ namespace VkEngine {
       .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT
     };
 
+    constexpr VkDescriptorSetLayoutBinding chromaTextureLayout {
+      .binding = 3,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT
+    };
+
     constexpr std::array objectBindings {
       textureLayout,
-      screenSizeLayout
+      screenSizeLayout,
+      chromaTextureLayout
     };
 
     const VkDescriptorSetLayoutCreateInfo objectLayoutCreateInfo {
@@ -179,7 +200,7 @@ namespace VkEngine {
     const std::array<VkDescriptorPoolSize, 11> poolSizes {
       {
         {VK_DESCRIPTOR_TYPE_SAMPLER, MAX_FRAMES_IN_FLIGHT},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_FRAMES_IN_FLIGHT},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_FRAMES_IN_FLIGHT * 2},
         {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MAX_FRAMES_IN_FLIGHT},
         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_FRAMES_IN_FLIGHT},
         {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, MAX_FRAMES_IN_FLIGHT},
@@ -2,6 +2,7 @@
 #define VIDEOPIPELINE_H
 
 #include "../GraphicsPipeline.h"
+#include "../../VideoFrameFormat.h"
 #include <vulkan/vulkan.h>
 #include <memory>
 
@@ -15,6 +16,10 @@ struct ScreenSizeUniform {
   float height;
   float imageAspectRatio;
   int grayscale;
+  int videoFormat;
+  int colorMatrix;
+  int fullRange;
+  int padding;
 };
 
 class VideoPipeline final : public GraphicsPipeline {
@@ -26,7 +31,8 @@ public:
   ~VideoPipeline() override;
 
   void render(const VkCommandBuffer& commandBuffer, VkExtent2D swapChainExtent, const VkDescriptorImageInfo* imageInfo,
-              uint32_t currentFrame, float imageAspectRatio, bool grayscale) const;
+              const VkDescriptorImageInfo* chromaImageInfo, uint32_t currentFrame, float imageAspectRatio,
+              bool grayscale, const VideoFrameFormat& frameFormat) const;
 
 private:
   VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
@@ -7,14 +7,59 @@ layout(set = 0, binding = 2) uniform ScreenSize {
   float height;
   float imageAspectRatio;
   int grayscale;
+  int videoFormat; // 0 = RGBA, 1 = NV12
+  int colorMatrix; // 0 = BT.601, 1 = BT.709, 2 = BT.2020
+  int fullRange;
 } screenSize;
 
+// UV plane of NV12 frames
+layout(set = 0, binding = 3) uniform sampler2D chromaSampler;
+
 layout(location = 0) in vec3 fragPos;
 layout(location = 1) in vec2 fragTexCoord;
 layout(location = 2) in vec3 fragNormal;
 
 layout(location = 0) out vec4 outColor;
 
+vec3 sampleVideo(vec2 uv)
+{
+  if (screenSize.videoFormat == 0)
+  {
+    return texture(texSampler, uv).rgb;
+  }
+
+  float y = texture(texSampler, uv).r;
+  vec2 cbcr = texture(chromaSampler, uv).rg;
+
+  if (screenSize.fullRange != 0)
+  {
+    cbcr -= 0.5;
+  }
+  else
+  {
+    // Expand limited range (16-235 luma, 16-240 chroma)
+    y = (y - 16.0 / 255.0) * (255.0 / 219.0);
+    cbcr = (cbcr - 128.0 / 255.0) * (255.0 / 224.0);
+  }
+
+  // Luma weights of red and blue for each matrix
+  vec2 k = vec2(0.2126, 0.0722);
+  if (screenSize.colorMatrix == 0)
+  {
+    k = vec2(0.299, 0.114);
+  }
+  else if (screenSize.colorMatrix == 2)
+  {
+    k = vec2(0.2627, 0.0593);
+  }
+
+  float r = y + 2.0 * (1.0 - k.x) * cbcr.y;
+  float b = y + 2.0 * (1.0 - k.y) * cbcr.x;
+  float g = (y - k.x * r - k.y * b) / (1.0 - k.x - k.y);
+
+  return clamp(vec3(r, g, b), 0.0, 1.0);
+}
+
 void main()
 {
   float screenAspect = screenSize.width / screenSize.height;
@@ -42,7 +87,7 @@ void main()
   }
   else
   {
-    vec3 texColor = texture(texSampler, adjustedUV).rgb;
+    vec3 texColor = sampleVideo(adjustedUV);
 
     if (screenSize.grayscale != 0)
     {
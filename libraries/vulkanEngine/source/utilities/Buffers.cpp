@@ -109,12 +109,25 @@ namespace VkEngine::Buffers {
       .pCommandBuffers = &commandBuffer
     };
 
-    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    constexpr VkFenceCreateInfo fenceInfo {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+    };
+
+    VkFence fence = VK_NULL_HANDLE;
+    if (vkCreateFence(logicalDevice->getDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create command buffer fence!");
+    }
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
     {
+      vkDestroyFence(logicalDevice->getDevice(), fence, nullptr);
       throw std::runtime_error("failed to submit command buffer!");
     }
 
-    vkQueueWaitIdle(queue);
+    // Only wait for this submission, not for frames already queued behind it
+    vkWaitForFences(logicalDevice->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+    vkDestroyFence(logicalDevice->getDevice(), fence, nullptr);
 
     vkFreeCommandBuffers(logicalDevice->getDevice(), commandPool, 1, &commandBuffer);
   }
@@ -10,8 +10,11 @@ namespace VkEngine::Images {
                    const uint32_t depth, const uint32_t mipLevels, const VkSampleCountFlagBits numSamples,
                    const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage,
                    const VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory,
-                   const VkImageType imageType)
+                   const VkImageType imageType, const std::vector<uint32_t>& sharingQueueFamilies)
   {
+    // Images used by more than one queue family are shared concurrently instead of transferring ownership
+    const bool concurrent = sharingQueueFamilies.size() > 1;
+
     const VkImageCreateInfo imageCreateInfo {
       .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
       .imageType = imageType,
@@ -26,7 +29,9 @@ namespace VkEngine::Images {
       .samples = numSamples,
       .tiling = tiling,
       .usage = usage,
-      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(sharingQueueFamilies.size()) : 0,
+      .pQueueFamilyIndices = concurrent ? sharingQueueFamilies.data() : nullptr,
       .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
     };
 
@@ -58,6 +63,15 @@ namespace VkEngine::Images {
   {
     const VkCommandBuffer commandBuffer = Buffers::beginSingleTimeCommands(logicalDevice, commandPool);
 
+    recordTransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout, mipLevels);
+
+    Buffers::endSingleTimeCommands(logicalDevice, commandPool, logicalDevice->getGraphicsQueue(), commandBuffer);
+  }
+
+  void recordTransitionImageLayout(const VkCommandBuffer& commandBuffer, const VkImage image, const VkFormat format,
+                                   const VkImageLayout oldLayout, const VkImageLayout newLayout,
+                                   const uint32_t mipLevels)
+  {
     VkImageMemoryBarrier barrier {
       .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
       .oldLayout = oldLayout,
@@ -106,6 +120,15 @@ namespace VkEngine::Images {
       sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
       destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     }
+    else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    {
+      // Updating part of an image that is sampled, earlier reads must finish and the rest of it is kept
+      barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+      sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
     else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
     {
       barrier.srcAccessMask = 0;
@@ -135,8 +158,6 @@ namespace VkEngine::Images {
       0, nullptr,
       1, &barrier
     );
-
-    Buffers::endSingleTimeCommands(logicalDevice, commandPool, logicalDevice->getGraphicsQueue(), commandBuffer);
   }
 
   void copyBufferToImage(const std::shared_ptr<LogicalDevice>& logicalDevice, const VkCommandPool& commandPool,
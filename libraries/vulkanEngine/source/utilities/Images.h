@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan.h>
 #include <memory>
+#include <vector>
 
 namespace VkEngine {
 
@@ -14,12 +15,17 @@ namespace Images {
                    const std::shared_ptr<PhysicalDevice>& physicalDevice, uint32_t width, uint32_t height,
                    uint32_t depth, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format,
                    VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-                   VkDeviceMemory& imageMemory, VkImageType imageType);
+                   VkDeviceMemory& imageMemory, VkImageType imageType,
+                   const std::vector<uint32_t>& sharingQueueFamilies = {});
 
   void transitionImageLayout(const std::shared_ptr<LogicalDevice>& logicalDevice, const VkCommandPool& commandPool,
                              VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout,
                              uint32_t mipLevels);
 
+  // Records the barrier of transitionImageLayout into an existing command buffer instead of submitting it
+  void recordTransitionImageLayout(const VkCommandBuffer& commandBuffer, VkImage image, VkFormat format,
+                                   VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
+
   void copyBufferToImage(const std::shared_ptr<LogicalDevice>& logicalDevice, const VkCommandPool& commandPool,
                          VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t depth);
 
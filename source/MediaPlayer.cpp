@@ -1,18 +1,38 @@
 #include "MediaPlayer.h"
 #include "../libraries/AudioToTxt/tests/test_whisper/audioDecoding.h"
 #include <components/ImGuiInstance.h>
+#include <array>
+#include <cstdio>
 #include <iostream>
 #include <filesystem>
 
 constexpr AVParser::AudioParams audioParams;
 constexpr Audio::AudioParams audioParams2;
 
-MediaPlayer::MediaPlayer(const char* asset)
-  : asset{asset}, parser{std::make_unique<AVParser::MediaParser>(asset, audioParams)}
+// Keep decoded frames as NV12, the video shader converts them to RGB
+constexpr AVParser::DecoderParams decoderParams {
+  .frameFormat = AVParser::FrameFormat::NV12
+};
+
+// Speeds offered in the transport controls and stepped through with [ and ]
+constexpr std::array playbackRates { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0, 64.0 };
+
+MediaPlayer::MediaPlayer(const std::vector<std::string>& assets, const bool loopPlaylist)
+  : asset{assets.at(0)}, parser{std::make_unique<AVParser::MediaParser>(asset, audioParams, decoderParams,
+                                                                       AVParser::OpenMode::PROGRESSIVE)},
+    playlist{std::next(assets.begin()), assets.end()}, loopPlaylist{loopPlaylist}
 {
+  // A looping playlist always ends with the file playing, which comes around again after the others
+  if (loopPlaylist)
+  {
+    playlist.push_back(asset);
+  }
+
   startCaptionsLoading();
 
   audioPlayer = std::make_unique<Audio::AudioPlayer>(audioParams2);
+  timeStretch = std::make_unique<Audio::TimeStretch>(audioParams2.sampleRate, audioParams2.channels,
+                                                     Audio::SampleFormat::S16);
 
   createWindow();
 }
@@ -27,19 +47,24 @@ MediaPlayer::~MediaPlayer()
 
 void MediaPlayer::run()
 {
-  const auto initialFrame = parser->getCurrentFrame();
-  vulkanEngine->loadVideoFrame(initialFrame.videoData, initialFrame.frameWidth, initialFrame.frameHeight);
+  loadVideoFrame(parser->getCurrentFrame());
   parser->pause();
 
   audioPlayer->stop();
 
+  // A looping playlist is meant to run unattended
+  if (loopPlaylist)
+  {
+    parser->play();
+    audioPlayer->start();
+  }
+
   while (vulkanEngine->isActive())
   {
     if (shouldRecreateWindow)
     {
       createWindow();
-      const auto currentFrame = parser->getCurrentFrame();
-      vulkanEngine->loadVideoFrame(currentFrame.videoData, currentFrame.frameWidth, currentFrame.frameHeight);
+      loadVideoFrame(parser->getCurrentFrame());
       continue;
     }
 
@@ -51,9 +76,18 @@ void MediaPlayer::run()
       }
 
       std::lock_guard lock(captionsMutex);
-      captionCache = std::make_unique<Captions::CaptionCache>("assets/subtitles.srt");
 
-      captionsReady = true;
+      // Transcribed a file that was switched away from meanwhile
+      if (captionedAsset != asset)
+      {
+        startCaptionsLoading();
+      }
+      else
+      {
+        captionCache = std::make_unique<Captions::CaptionCache>("assets/subtitles.srt");
+
+        captionsReady = true;
+      }
     }
 
     update();
@@ -80,13 +114,55 @@ void MediaPlayer::createWindow()
   vulkanEngine = std::make_unique<VkEngine::VulkanEngine>(fullscreen ? fullscreenVulkanEngineOptions : vulkanEngineOptions);
   ImGui::SetCurrentContext(VkEngine::VulkanEngine::getImGuiContext());
 
+  // The new engine starts without a thumbnail atlas
+  uploadedThumbnails.clear();
+
   shouldRecreateWindow = false;
 }
 
+void MediaPlayer::loadVideoFrame(const AVParser::AVFrameData& frame) const
+{
+  const VkEngine::VideoFrameFormat frameFormat {
+    .format = frame.frameFormat == AVParser::FrameFormat::NV12 ? VkEngine::VideoFormat::NV12
+                                                                : VkEngine::VideoFormat::RGBA,
+    .colorMatrix = frame.colorMatrix == AVParser::ColorMatrix::BT601 ? VkEngine::ColorMatrix::BT601
+                 : frame.colorMatrix == AVParser::ColorMatrix::BT2020 ? VkEngine::ColorMatrix::BT2020
+                                                                       : VkEngine::ColorMatrix::BT709,
+    .fullRange = frame.fullRange
+  };
+
+  vulkanEngine->loadVideoFrame(frame.videoData, frame.frameWidth, frame.frameHeight, frameFormat);
+}
+
 void MediaPlayer::startCaptionsLoading()
 {
+  captionsLoaded = false;
+  captionedAsset = asset;
+
   // Create a new thread to load captions
-  captionsThread = std::thread(&MediaPlayer::loadCaptions, this);
+  captionsThread = std::thread(&MediaPlayer::loadCaptions, this, captionedAsset);
+}
+
+void MediaPlayer::restartCaptions()
+{
+  // The same file again, e.g. a playlist looping over a single file
+  if (captionedAsset == asset)
+  {
+    return;
+  }
+
+  std::lock_guard lock(captionsMutex);
+
+  captionCache.reset();
+  captionsReady = false;
+
+  // Still transcribing an earlier file, run starts this one once it is done
+  if (captionsThread.joinable())
+  {
+    return;
+  }
+
+  startCaptionsLoading();
 }
 
 bool MediaPlayer::areCaptionsLoaded()
@@ -96,7 +172,7 @@ bool MediaPlayer::areCaptionsLoaded()
   return captionsLoaded;
 }
 
-void MediaPlayer::loadCaptions()
+void MediaPlayer::loadCaptions(const std::string& mediaFile)
 {
   const std::string assetsPath = "assets/";
 
@@ -105,7 +181,7 @@ void MediaPlayer::loadCaptions()
   const std::string outputVideo = assetsPath + "output_with_subtitles_turbo.mp4";
   const std::string modelPath = "models/ggml-large-v3-turbo-q5_0.bin"; // "ggml-base.bin"
 
-  if (!extractAudio(asset, audioFile))
+  if (!extractAudio(mediaFile, audioFile))
   {
     throw std::runtime_error("Failed to generate formated audio file");
   }
@@ -132,9 +208,47 @@ void MediaPlayer::update()
   gui->dockBottom("Media Player Controls");
   gui->dockBottom("Special Effects");
   gui->setBottomDockPercent(0.3);
+  updateThumbnails();
   displayGui();
 
-  parser->update();
+  preloadNext();
+
+  // A seek after the next file's audio was queued behind this one's starts the next file's audio over
+  if (nextAudioStarted && !parser->isAudioFinished())
+  {
+    nextParser->loadFrameAt(0);
+    nextAudioStarted = false;
+  }
+
+  // The device plays this file's audio before the next one's
+  nextAudioQueued = std::min(nextAudioQueued, audioPlayer->getAvailableBuffer());
+
+  // Audio drives the video, whatever is still queued on the device or in the stretcher hasn't been heard yet. The
+  // device plays the stretched audio, which covers rate times as much of the parser's
+  const int queuedBytes = audioPlayer->getAvailableBuffer() - nextAudioQueued;
+  const auto queuedAudio = static_cast<int>(queuedBytes * parser->getPlaybackRate());
+  const int stretcherBytes = nextAudioStarted ? 0 : timeStretch->getBufferedBytes();
+
+  const bool wasPlaying = parser->getState() == AVParser::MediaState::AUTO_PLAYING;
+  parser->update(queuedAudio + stretcherBytes);
+
+  // The parser pauses itself once the last frame was shown
+  if (wasPlaying && parser->getState() == AVParser::MediaState::PAUSED && parser->isAtEnd() && !playlist.empty() &&
+      pendingAdvance == PlaylistAdvance::NONE)
+  {
+    pendingAdvance = PlaylistAdvance::GAPLESS;
+  }
+
+  // Seeked away from the end while the next file was still being opened
+  if (pendingAdvance == PlaylistAdvance::GAPLESS && !parser->isAtEnd())
+  {
+    pendingAdvance = PlaylistAdvance::NONE;
+  }
+
+  if (pendingAdvance != PlaylistAdvance::NONE && nextParser)
+  {
+    playNext();
+  }
 
   std::string caption = "Loading captions...";
   if (captionsReady)
@@ -144,34 +258,66 @@ void MediaPlayer::update()
 
   vulkanEngine->loadCaption(caption.c_str());
 
-  if (const uint32_t currentFrameIndex = parser->getCurrentFrameIndex(); currentFrameIndex != previousFrameIndex)
+  if (const auto frame = parser->getCurrentFrame(); frame.videoData != previousVideoData)
   {
-    const auto frame = parser->getCurrentFrame();
+    loadVideoFrame(frame);
 
-    vulkanEngine->loadVideoFrame(frame.videoData, frame.frameWidth, frame.frameHeight);
-
-    previousFrameIndex = currentFrameIndex;
+    previousVideoData = frame.videoData;
   }
 
   vulkanEngine->render();
 
-  if (parser->getState() == AVParser::MediaState::AUTO_PLAYING)
+  // Decode at the size the video is shown at, the viewport is only known once the GUI has been laid out
+  if (const auto viewport = vulkanEngine->getVideoViewportExtent(); viewport.width > 0 && viewport.height > 0)
   {
-    // Check if we need to add more audio data
-    const int available = audioPlayer->getAvailableBuffer();
-    constexpr int bytesPerSecond = audioParams2.sampleRate * audioParams2.channels * (audioParams2.bitsPerSample / 8);
+    parser->setOutputSize(static_cast<int>(viewport.width), static_cast<int>(viewport.height));
+  }
 
-    // If buffer needs more data, decode and queue it
-    if (available < bytesPerSecond)
-    {
-      uint8_t* buffer = nullptr;
-      int bufferSize = 0;
+  queueAudio();
+}
 
-      if (parser->getNextAudioChunk(buffer, bufferSize))
-      {
-        audioPlayer->queueAudio(buffer, bufferSize);
-      }
-    }
+void MediaPlayer::queueAudio()
+{
+  // Audio is only played forwards, at rates it is still intelligible at
+  if (parser->getState() != AVParser::MediaState::AUTO_PLAYING || !parser->isAudible())
+  {
+    return;
+  }
+
+  // Check if we need to add more audio data
+  const int available = audioPlayer->getAvailableBuffer();
+  constexpr int bytesPerSecond = audioParams2.sampleRate * audioParams2.channels * (audioParams2.bitsPerSample / 8);
+
+  if (available >= bytesPerSecond)
+  {
+    return;
+  }
+
+  // Once this file's audio is all queued the next file's follows right behind it, unless the user picked another file
+  const bool handOff = nextParser && pendingAdvance != PlaylistAdvance::CUT && parser->isAudioFinished();
+  AVParser::MediaParser& source = handOff ? *nextParser : *parser;
+
+  // If buffer needs more data, decode and queue it
+  const uint8_t* buffer = nullptr;
+  int bufferSize = 0;
+
+  if (!source.getNextAudioChunk(buffer, bufferSize))
+  {
+    return;
+  }
+
+  // Keeps the pitch away from 1x, at 1x the chunk is passed through as is
+  const auto stretched = timeStretch->process({ buffer, static_cast<size_t>(bufferSize) });
+
+  if (!stretched.empty())
+  {
+    audioPlayer->queueAudio(stretched.data(), static_cast<int>(stretched.size()));
+  }
+
+  if (handOff)
+  {
+    nextAudioStarted = true;
+    nextAudioQueued += static_cast<int>(stretched.size());
   }
 }
 
@@ -225,7 +371,8 @@ void MediaPlayer::handleKeyInput()
         parser->play();
         audioPlayer->start();
       }
-      else if (parser->getState() == AVParser::MediaState::AUTO_PLAYING)
+      else if (parser->getState() == AVParser::MediaState::AUTO_PLAYING ||
+               parser->getState() == AVParser::MediaState::REVERSE_PLAYING)
       {
         parser->pause();
         audioPlayer->stop();
@@ -233,6 +380,15 @@ void MediaPlayer::handleKeyInput()
     }
   });
 
+  // Handle reverse playback toggle (J)
+  processKeyPress(GLFW_KEY_J, [&](const bool justPressed, bool held, int counter)
+  {
+    if (justPressed)
+    {
+      toggleReverse();
+    }
+  });
+
   // Handle play/pause toggle (Space)
   processKeyPress(GLFW_KEY_F11, [&](bool justPressed, bool held, int counter)
   {
@@ -276,12 +432,30 @@ void MediaPlayer::handleKeyInput()
   // Handle left key (backward)
   handleNavKey(GLFW_KEY_LEFT, -10, -5);
 
+  // Handle playback speed ([ slower, ] faster)
+  processKeyPress(GLFW_KEY_LEFT_BRACKET, [&](const bool justPressed, bool held, int counter)
+  {
+    if (justPressed)
+    {
+      setPlaybackRate(parser->getPlaybackRate() / 2);
+    }
+  });
+
+  processKeyPress(GLFW_KEY_RIGHT_BRACKET, [&](const bool justPressed, bool held, int counter)
+  {
+    if (justPressed)
+    {
+      setPlaybackRate(parser->getPlaybackRate() * 2);
+    }
+  });
+
   // Handle reset to beginning (R key)
   processKeyPress(GLFW_KEY_R, [&](const bool justPressed, bool held, int counter)
   {
     if (justPressed)
     {
       parser->loadFrameAt(0);
+      clearAudio();
     }
   });
 }
@@ -324,7 +498,22 @@ void MediaPlayer::menuBarGui()
         fileDialog.SetTitle("Select a Media File");
         fileDialog.SetTypeFilters({".mp4", ".avi", ".mkv", ".mov"}); // Allow video files
         fileDialog.Open();  // Open the file dialog
+        enqueueSelection = false;
+      }
+
+      if (ImGui::MenuItem("Add to Playlist"))
+      {
+        fileDialog.SetTitle("Select a Media File to Play Next");
+        fileDialog.SetTypeFilters({".mp4", ".avi", ".mkv", ".mov"});
+        fileDialog.Open();
+        enqueueSelection = true;
       }
+
+      if (ImGui::MenuItem("Next in Playlist", nullptr, false, !playlist.empty()))
+      {
+        pendingAdvance = PlaylistAdvance::CUT;
+      }
+
       ImGui::EndMenu();
     }
 
@@ -364,14 +553,21 @@ void MediaPlayer::menuBarGui()
   fileDialog.Display();
 
   // Handle file selection
-  if (fileDialog.HasSelected()) 
+  if (fileDialog.HasSelected())
   {
-    std::string filePath = fileDialog.GetSelected().string();
-    //Set file path
-    asset = filePath.c_str();
+    const std::string filePath = fileDialog.GetSelected().string();
     fileDialog.ClearSelected();
-    //Reload with new file
-    loadNewFile();
+
+    if (enqueueSelection)
+    {
+      // A looping playlist keeps the file playing at its end
+      playlist.insert(loopPlaylist && !playlist.empty() ? std::prev(playlist.end()) : playlist.end(), filePath);
+    }
+    else
+    {
+      //Reload with new file
+      loadNewFile(filePath);
+    }
   }
 }
 
@@ -386,11 +582,37 @@ void MediaPlayer::timelineGui()
 
   // Center the seek bar
   ImGui::SetCursorPosX((windowWidth - ImGui::CalcItemWidth()) * 0.5f);
+  filmstripGui(ImGui::CalcItemWidth());
+  ImGui::SetCursorPosX((windowWidth - ImGui::CalcItemWidth()) * 0.5f);
 
   // Seek bar (progress bar)
-  if (ImGui::SliderInt("##timeline", reinterpret_cast<int*>(&currentFrameIndex), 0, static_cast<int>(totalFrames),""))
+  // Dragging shows keyframe previews, the exact frame is loaded on release
+  const bool timelineChanged = ImGui::SliderInt("##timeline", reinterpret_cast<int*>(&currentFrameIndex), 0,
+                                                static_cast<int>(totalFrames),"");
+  if (ImGui::IsItemActivated())
+  {
+    parser->beginScrub();
+    clearAudio();
+  }
+
+  if (ImGui::IsItemHovered() && !ImGui::IsItemActive())
+  {
+    const ImVec2 sliderMin = ImGui::GetItemRectMin();
+    const ImVec2 sliderMax = ImGui::GetItemRectMax();
+    const float position = std::clamp((ImGui::GetMousePos().x - sliderMin.x) / (sliderMax.x - sliderMin.x), 0.0f, 1.0f);
+
+    thumbnailTooltipGui(static_cast<uint32_t>(position * static_cast<float>(totalFrames)));
+  }
+
+  if (timelineChanged)
+  {
+    parser->scrubTo(currentFrameIndex);
+  }
+
+  if (ImGui::IsItemDeactivated())
   {
-    parser->loadFrameAt(currentFrameIndex);
+    parser->endScrub();
+    clearAudio();
   }
 
   // Transport control buttons
@@ -399,8 +621,10 @@ void MediaPlayer::timelineGui()
   constexpr float buttonSize = 100.0f; // Adjusted button size to fit text
   constexpr float smallButtonSize = 50.0f; // Adjusted small button size to fit text
 
+  constexpr float speedComboWidth = 70.0f;
+
   // Calculate the total width of all controls
-  constexpr float totalControlsWidth = buttonSize + smallButtonSize * 2; // 1 main button (Play/Pause) + 2 small buttons
+  constexpr float totalControlsWidth = buttonSize * 2 + smallButtonSize * 2 + speedComboWidth;
 
   // Center the controls in the window
   const float centerPos = (windowWidth - totalControlsWidth) / 2.0f;
@@ -413,6 +637,14 @@ void MediaPlayer::timelineGui()
   }
   ImGui::SameLine();
 
+  // Reverse button
+  if (ImGui::Button(parser->getState() == AVParser::MediaState::REVERSE_PLAYING ? "Stop Reverse" : "Reverse",
+                    ImVec2(buttonSize, 0)))
+  {
+    toggleReverse();
+  }
+  ImGui::SameLine();
+
   // Play/Pause button
   if (parser->getState() == AVParser::MediaState::AUTO_PLAYING)
   {
@@ -437,6 +669,118 @@ void MediaPlayer::timelineGui()
   {
     navigateFrames(30);
   }
+  ImGui::SameLine();
+
+  // Playback speed
+  char rateLabel[16];
+  std::snprintf(rateLabel, sizeof(rateLabel), "%gx", parser->getPlaybackRate());
+
+  ImGui::SetNextItemWidth(speedComboWidth);
+  if (ImGui::BeginCombo("##speed", rateLabel))
+  {
+    for (const double rate : playbackRates)
+    {
+      std::snprintf(rateLabel, sizeof(rateLabel), "%gx", rate);
+
+      if (ImGui::Selectable(rateLabel, rate == parser->getPlaybackRate()))
+      {
+        setPlaybackRate(rate);
+      }
+    }
+
+    ImGui::EndCombo();
+  }
+}
+
+void MediaPlayer::updateThumbnails()
+{
+  const auto& thumbnails = parser->getThumbnails();
+  if (thumbnails.getCount() == 0)
+  {
+    return;
+  }
+
+  if (uploadedThumbnails.empty())
+  {
+    vulkanEngine->createThumbnailAtlas(thumbnails.getWidth(), thumbnails.getHeight(), thumbnails.getCount());
+    uploadedThumbnails.assign(thumbnails.getCount(), false);
+  }
+
+  // Thumbnails are decoded in the background, upload whichever finished since the last frame
+  for (uint32_t i = 0; i < thumbnails.getCount(); i++)
+  {
+    if (uploadedThumbnails[i])
+    {
+      continue;
+    }
+
+    if (const uint8_t* pixels = thumbnails.getPixels(i))
+    {
+      vulkanEngine->loadThumbnail(i, pixels);
+      uploadedThumbnails[i] = true;
+    }
+  }
+}
+
+void MediaPlayer::filmstripGui(const float width) const
+{
+  const auto& thumbnails = parser->getThumbnails();
+  if (thumbnails.getCount() == 0)
+  {
+    return;
+  }
+
+  constexpr float stripHeight = 40.0f;
+  const float thumbnailWidth = stripHeight * static_cast<float>(thumbnails.getWidth()) /
+                               static_cast<float>(thumbnails.getHeight());
+
+  // Stretch the thumbnails a little so the strip lines up with the seek bar
+  const int count = std::max(1, static_cast<int>(width / thumbnailWidth));
+  const float cellWidth = width / static_cast<float>(count);
+
+  const uint64_t totalFrames = parser->getTotalFrames();
+
+  for (int i = 0; i < count; i++)
+  {
+    if (i > 0)
+    {
+      ImGui::SameLine(0, 0);
+    }
+
+    const auto frame = static_cast<uint32_t>(totalFrames * i / count);
+
+    if (const auto image = vulkanEngine->getThumbnail(thumbnails.findThumbnail(frame)); image.texture)
+    {
+      ImGui::Image(image.texture, { cellWidth, stripHeight }, image.uv0, image.uv1);
+    }
+    else
+    {
+      ImGui::Dummy({ cellWidth, stripHeight });
+    }
+  }
+}
+
+void MediaPlayer::thumbnailTooltipGui(const uint32_t frame) const
+{
+  const auto& thumbnails = parser->getThumbnails();
+  if (thumbnails.getCount() == 0)
+  {
+    return;
+  }
+
+  const auto image = vulkanEngine->getThumbnail(thumbnails.findThumbnail(frame));
+  if (!image.texture)
+  {
+    return;
+  }
+
+  const auto seconds = static_cast<int>(frame / parser->getFrameRate());
+
+  ImGui::BeginTooltip();
+  ImGui::Image(image.texture, { static_cast<float>(thumbnails.getWidth()), static_cast<float>(thumbnails.getHeight()) },
+               image.uv0, image.uv1);
+  ImGui::Text("%d:%02d", seconds / 60, seconds % 60);
+  ImGui::EndTooltip();
 }
 
 void MediaPlayer::volumeGui() const
@@ -478,24 +822,170 @@ void MediaPlayer::navigateFrames(const int numFrames) const
   const uint32_t newFrame = std::clamp(currentFrame + numFrames, 0, maxFrames);
 
   parser->loadFrameAt(newFrame);
+  clearAudio();
 }
 
-void MediaPlayer::loadNewFile()
+void MediaPlayer::toggleReverse() const
 {
-  // Stop current audio
+  // The audio isn't played backwards, drop what is still queued
   audioPlayer->stop();
+  clearAudio();
+
+  if (parser->getState() == AVParser::MediaState::REVERSE_PLAYING)
+  {
+    parser->pause();
+  }
+  else
+  {
+    parser->playReverse();
+  }
+}
+
+void MediaPlayer::setPlaybackRate(const double rate) const
+{
+  parser->setPlaybackRate(std::clamp(rate, playbackRates.front(), playbackRates.back()));
+  timeStretch->setRate(parser->getPlaybackRate());
+
+  // Audio queued at the old speed no longer matches the video
+  clearAudio();
+}
+
+void MediaPlayer::clearAudio() const
+{
+  audioPlayer->clear();
+  timeStretch->clear();
+}
+
+void MediaPlayer::loadNewFile(const std::string& mediaFile)
+{
+  // Opened in the background like the next file of the playlist, the current file keeps playing until then
+  playlist.push_front(mediaFile);
+  pendingAdvance = PlaylistAdvance::CUT;
+}
+
+void MediaPlayer::preloadNext()
+{
+  if (nextParserLoad.valid() && nextParserLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    try
+    {
+      nextParser = nextParserLoad.get();
+    }
+    catch (const std::exception& e)
+    {
+      // Skip a file that can't be played instead of stopping the playlist
+      std::cerr << "Skipping " << nextAsset << ": " << e.what() << std::endl;
+
+      // A file opened meanwhile is still at the front and keeps its cut
+      if (!playlist.empty() && playlist.front() == nextAsset)
+      {
+        playlist.pop_front();
+
+        if (pendingAdvance == PlaylistAdvance::CUT)
+        {
+          pendingAdvance = PlaylistAdvance::NONE;
+        }
+      }
+    }
+  }
+
+  // The playlist changed while the file was opened, e.g. another file was opened meanwhile
+  if (nextParser && (playlist.empty() || playlist.front() != nextAsset))
+  {
+    // Its audio may be queued behind this file's already, it would be played for a file that is never shown. This
+    // file's audio was all queued by then, its last frames follow the system clock once the device is cleared
+    if (nextAudioStarted || nextAudioQueued > 0)
+    {
+      clearAudio();
+    }
+
+    retireParser(std::move(nextParser));
+    nextAudioQueued = 0;
+    nextAudioStarted = false;
+  }
+
+  if (nextParser || nextParserLoad.valid() || playlist.empty())
+  {
+    return;
+  }
+
+  nextAsset = playlist.front();
+
+  const auto viewport = vulkanEngine->getVideoViewportExtent();
+
+  // The window keeps responding while the file is indexed. Opening it shows its first frame at the size the video is
+  // shown at, and the background loader decodes the audio around it meanwhile
+  nextParserLoad = std::async(std::launch::async, [mediaFile = nextAsset, viewport] {
+    auto next = std::make_unique<AVParser::MediaParser>(mediaFile, audioParams, decoderParams,
+                                                        AVParser::OpenMode::PROGRESSIVE);
+    next->pause();
+    next->setOutputSize(static_cast<int>(viewport.width), static_cast<int>(viewport.height));
+
+    return next;
+  });
+}
+
+void MediaPlayer::playNext()
+{
+  const bool play = pendingAdvance == PlaylistAdvance::GAPLESS ||
+                    parser->getState() == AVParser::MediaState::AUTO_PLAYING;
+
+  if (pendingAdvance == PlaylistAdvance::CUT)
+  {
+    clearAudio();
+
+    // The start of its audio may have been queued already and was just dropped
+    if (nextAudioStarted)
+    {
+      nextParser->loadFrameAt(0);
+    }
+  }
+
+  pendingAdvance = PlaylistAdvance::NONE;
+
+  const double rate = parser->getPlaybackRate();
+
+  retireParser(std::move(parser));
+  parser = std::move(nextParser);
+
+  asset = playlist.front();
+  playlist.pop_front();
+
+  if (loopPlaylist)
+  {
+    playlist.push_back(asset);
+  }
+
+  // Whatever of the new file's audio is queued is now the playing file's
+  nextAudioQueued = 0;
+  nextAudioStarted = false;
+
+  if (parser->getPlaybackRate() != rate)
+  {
+    parser->setPlaybackRate(rate);
+  }
+
+  if (play)
+  {
+    parser->play();
+  }
 
   // Initialize new video
-  parser.reset();
-  parser = std::make_unique<AVParser::MediaParser>(std::string(asset), audioParams);
-  const auto initialFrame = parser->getCurrentFrame();
-  vulkanEngine->loadVideoFrame(initialFrame.videoData, initialFrame.frameWidth, initialFrame.frameHeight);
-  parser->pause();
+  uploadedThumbnails.clear();
+  previousVideoData = nullptr;
 
-  std::lock_guard lock(captionsMutex);
-  captionsLoaded = false;
-  captionsReady = false;
-  startCaptionsLoading();
+  restartCaptions();
+}
+
+void MediaPlayer::retireParser(std::unique_ptr<AVParser::MediaParser> oldParser)
+{
+  // One at a time, the previous one is long gone unless files are switched in quick succession
+  if (retiredParser.valid())
+  {
+    retiredParser.wait();
+  }
 
-  update();
+  retiredParser = std::async(std::launch::async, [oldParser = std::move(oldParser)]() mutable {
+    oldParser.reset();
+  });
 }
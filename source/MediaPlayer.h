@@ -2,6 +2,7 @@
 #define MEDIAPLAYER_H
 
 #include <AudioPlayer.h>
+#include <TimeStretch.h>
 #include <AudioToTxt.h>
 #include <AVParser.h>
 #include <VulkanEngine.h>
@@ -9,6 +10,10 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
 #include <imfilebrowser.h>
 
 constexpr VkEngine::VulkanEngineOptions vulkanEngineOptions {
@@ -24,28 +29,61 @@ constexpr VkEngine::VulkanEngineOptions fullscreenVulkanEngineOptions {
 
 class MediaPlayer {
 public:
-  explicit MediaPlayer(const char* asset);
+  // Plays the files in order, starting over after the last one if loopPlaylist is set
+  explicit MediaPlayer(const std::vector<std::string>& assets, bool loopPlaylist = false);
 
   ~MediaPlayer();
 
   void run();
 
 private:
-  const char* asset;
+  // When to switch to the next file once it is opened
+  enum class PlaylistAdvance {
+    NONE,
+    GAPLESS, // The current file finished, its audio runs straight into the next one's
+    CUT      // Picked by the user, the current file's audio is dropped
+  };
 
-  ImGui::FileBrowser fileDialog;  
+  std::string asset;
+
+  ImGui::FileBrowser fileDialog;
+
+  // Whether the file picked in the dialog is queued instead of opened
+  bool enqueueSelection = false;
 
   std::unique_ptr<VkEngine::VulkanEngine> vulkanEngine;
 
   std::unique_ptr<AVParser::MediaParser> parser;
 
+  // Files after the current one, the first of them is opened in the background while the current one plays
+  std::deque<std::string> playlist;
+  bool loopPlaylist;
+
+  std::future<std::unique_ptr<AVParser::MediaParser>> nextParserLoad;
+  std::string nextAsset;
+  std::unique_ptr<AVParser::MediaParser> nextParser;
+
+  PlaylistAdvance pendingAdvance = PlaylistAdvance::NONE;
+
+  // Bytes of the next file's audio queued on the device behind the end of the current file's
+  int nextAudioQueued = 0;
+  bool nextAudioStarted = false;
+
+  // Parsers being destroyed off the UI thread, their threads take a moment to stop
+  std::future<void> retiredParser;
+
   std::unique_ptr<Captions::CaptionCache> captionCache{};
 
   std::unique_ptr<Audio::AudioPlayer> audioPlayer{};
+  std::unique_ptr<Audio::TimeStretch> timeStretch{};
 
   uint32_t audioDurationRemaining = 0;
 
-  uint32_t previousFrameIndex = 0;
+  // Buffer last handed to the renderer, a new buffer means a new frame or a scrub preview
+  std::shared_ptr<std::vector<uint8_t>> previousVideoData;
+
+  // Thumbnails already in the renderer's atlas, empty until the atlas is created
+  std::vector<bool> uploadedThumbnails;
 
   std::thread captionsThread;
   std::mutex captionsMutex;
@@ -53,6 +91,9 @@ private:
   bool captionsLoaded = false;
   bool captionsReady = false;
 
+  // File the captions thread transcribes, captions for a file switched to meanwhile start once it is done
+  std::string captionedAsset;
+
   bool fullscreen = false;
 
   bool shouldRecreateWindow = true;
@@ -70,11 +111,16 @@ private:
 
   void createWindow();
 
+  void loadVideoFrame(const AVParser::AVFrameData& frame) const;
+
   void startCaptionsLoading();
 
   bool areCaptionsLoaded();
 
-  void loadCaptions();
+  void loadCaptions(const std::string& mediaFile);
+
+  // Starts the captions of the current file, or leaves them until the captions thread is done with the previous one
+  void restartCaptions();
 
   void update();
 
@@ -86,13 +132,38 @@ private:
 
   void timelineGui();
 
+  void updateThumbnails();
+
+  void filmstripGui(float width) const;
+
+  void thumbnailTooltipGui(uint32_t frame) const;
+
   void volumeGui() const;
 
   void sfxGui();
 
   void navigateFrames(int numFrames) const;
 
-  void loadNewFile();
+  void toggleReverse() const;
+
+  void setPlaybackRate(double rate) const;
+
+  // Drops the audio queued on the device and in the stretcher, e.g. after a seek
+  void clearAudio() const;
+
+  // Opens the file picked in the dialog in the background and switches to it once it shows its first frame
+  void loadNewFile(const std::string& mediaFile);
+
+  // Opens the first file of the playlist in the background, and takes the parser once it is open
+  void preloadNext();
+
+  // Queues the next file's audio once the current file's is all queued, so the device never runs dry in between
+  void queueAudio();
+
+  // Switches to the preloaded file, the window keeps showing the current one until then
+  void playNext();
+
+  void retireParser(std::unique_ptr<AVParser::MediaParser> oldParser);
 };
 
 #endif //MEDIAPLAYER_H
@@ -1,11 +1,33 @@
 #include "MediaPlayer.h"
 #include <iostream>
+#include <string_view>
 
 int main(const int argc, char* argv[])
 {
   try
   {
-    MediaPlayer mediaPlayer{argc == 2 ? argv[1] : "assets/CS_test.mp4"};
+    // Every file given is played in order, --loop starts over after the last one
+    std::vector<std::string> assets;
+    bool loopPlaylist = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+      if (std::string_view(argv[i]) == "--loop")
+      {
+        loopPlaylist = true;
+      }
+      else
+      {
+        assets.emplace_back(argv[i]);
+      }
+    }
+
+    if (assets.empty())
+    {
+      assets.emplace_back("assets/CS_test.mp4");
+    }
+
+    MediaPlayer mediaPlayer{assets, loopPlaylist};
 
     mediaPlayer.run();
   }